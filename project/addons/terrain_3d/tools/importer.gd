@@ -60,6 +60,13 @@ func start_import(p_value: bool) -> void:
 	if p_value:
 		print("Terrain3DImporter: Importing files:\n\t%s\n\t%s\n\t%s" % [ height_file_name, control_file_name, color_file_name])
 
+		# A height map alone is read from the file in strips, rather than loaded whole
+		if height_file_name and not control_file_name and not color_file_name:
+			var err: int = data.import_height_file(height_file_name, Vector3(import_position.x, 0, import_position.y),
+				height_offset, import_scale, r16_range, r16_size)
+			print("Terrain3DImporter: Import finished, status: ", error_string(err))
+			return
+
 		var imported_images: Array[Image]
 		imported_images.resize(Terrain3DRegion.TYPE_MAX)
 		var min_max := Vector2(0, 1)
@@ -9,6 +9,8 @@ using namespace godot;
 
 #define RS RenderingServer::get_singleton()
 #define IS_EDITOR Engine::get_singleton()->is_editor_hint()
+// The display server doesn't change while running, so each use compares the name only once
+#define IS_HEADLESS ([]() { static const bool headless = DisplayServer::get_singleton()->get_name() == "headless"; return headless; }())
 
 #define COLOR_NAN Color(NAN, NAN, NAN, NAN)
 #define COLOR_BLACK Color(0.0f, 0.0f, 0.0f, 1.0f)
@@ -1,5 +1,6 @@
 // Copyright © 2024 Cory Petkovsek, Roope Palmroos, and Contributors.
 
+#include <godot_cpp/classes/display_server.hpp>
 #include <godot_cpp/classes/rendering_server.hpp>
 
 #include "generated_texture.h"
@@ -31,7 +32,10 @@ RID GeneratedTexture::create(const TypedArray<Image> &p_layers) {
 				LOG(DEBUG_CONT, i, ": ", img, ", empty: ", img->is_empty(), ", size: ", img->get_size(), ", format: ", img->get_format());
 			}
 		}
-		_rid = RS->texture_2d_layered_create(p_layers, RenderingServer::TEXTURE_LAYERED_2D_ARRAY);
+		// When headless, nothing samples the texture, so the layers are only kept by the caller
+		if (!IS_HEADLESS) {
+			_rid = RS->texture_2d_layered_create(p_layers, RenderingServer::TEXTURE_LAYERED_2D_ARRAY);
+		}
 		_dirty = false;
 	} else {
 		clear();
@@ -42,7 +46,22 @@ RID GeneratedTexture::create(const TypedArray<Image> &p_layers) {
 RID GeneratedTexture::create(const Ref<Image> &p_image) {
 	LOG(DEBUG_CONT, "RenderingServer creating Texture2D");
 	_image = p_image;
-	_rid = RS->texture_2d_create(_image);
+	if (!IS_HEADLESS) {
+		_rid = RS->texture_2d_create(_image);
+	}
 	_dirty = false;
 	return _rid;
 }
+
+// Uploads an image to one layer of the existing texture. It must match the texture's size, format, and mipmaps
+void GeneratedTexture::update(const Ref<Image> &p_image, const int p_layer) {
+	if (IS_HEADLESS) {
+		return;
+	}
+	if (!_rid.is_valid() || p_image.is_null()) {
+		LOG(ERROR, "Texture or image is not valid");
+		return;
+	}
+	LOG(DEBUG_CONT, "RenderingServer updating texture layer ", p_layer);
+	RS->texture_2d_update(_rid, p_image, p_layer);
+}
@@ -22,6 +22,7 @@ public:
 	bool is_dirty() const { return _dirty; }
 	RID create(const TypedArray<Image> &p_layers);
 	RID create(const Ref<Image> &p_image);
+	void update(const Ref<Image> &p_image, const int p_layer = 0);
 	Ref<Image> get_image() const { return _image; }
 	RID get_rid() const { return _rid; }
 };
@@ -1,6 +1,7 @@
 // Copyright © 2024 Cory Petkovsek, Roope Palmroos, and Contributors.
 
 #include <godot_cpp/classes/collision_shape3d.hpp>
+#include <godot_cpp/classes/display_server.hpp>
 #include <godot_cpp/classes/editor_interface.hpp>
 #include <godot_cpp/classes/engine.hpp>
 #include <godot_cpp/classes/environment.hpp>
@@ -85,7 +86,10 @@ void Terrain3D::_initialize() {
 	// Initialize the system
 	if (!_initialized && _is_inside_world && is_inside_tree()) {
 		_data->initialize(this);
-		_material->initialize(this);
+		// A headless server keeps the data, collision and instances, but has nothing to render
+		if (!IS_HEADLESS) {
+			_material->initialize(this);
+		}
 		_assets->initialize(this);
 		_instancer->initialize(this);
 		_build_meshes(_mesh_lods, _mesh_size);
@@ -103,21 +107,32 @@ void Terrain3D::__process(const double p_delta) {
 	if (!_initialized)
 		return;
 
-	// If the game/editor camera is not set, find it
-	if (!is_instance_valid(_camera_instance_id, _camera)) {
-		LOG(DEBUG, "Camera is null, getting the current one");
-		_grab_camera();
-	}
+	// Finish any async save of the data
+	_data->_update_save();
+
+	// A headless server has no meshes to center, and may have no camera
+	if (!IS_HEADLESS && _snap_enabled) {
+		// If the game/editor camera is not set, find it
+		if (!is_instance_valid(_camera_instance_id, _camera)) {
+			LOG(DEBUG, "Camera is null, getting the current one");
+			_grab_camera();
+		}
 
-	// If camera has moved enough, re-center the terrain on it.
-	if (is_instance_valid(_camera_instance_id) && _camera->is_inside_tree()) {
-		Vector3 cam_pos = _camera->get_global_position();
-		Vector2 cam_pos_2d = Vector2(cam_pos.x, cam_pos.z);
-		if (_camera_last_position.distance_to(cam_pos_2d) > 0.2f) {
-			snap(cam_pos);
-			_camera_last_position = cam_pos_2d;
+		// If camera has moved enough, re-center the terrain on it.
+		if (is_instance_valid(_camera_instance_id) && _camera->is_inside_tree()) {
+			Vector3 cam_pos = _camera->get_global_position();
+			Vector2 cam_pos_2d = Vector2(cam_pos.x, cam_pos.z);
+			if (_camera_last_position.distance_to(cam_pos_2d) > 0.2f) {
+				snap(cam_pos);
+				_camera_last_position = cam_pos_2d;
+			}
 		}
 	}
+
+	// Instance collision is created only in game, like the terrain collision
+	if (_collision_enabled && !IS_EDITOR && _is_inside_world) {
+		_instancer->_update_collision();
+	}
 }
 
 /**
@@ -136,8 +151,8 @@ void Terrain3D::_grab_camera() {
 		_camera_instance_id = _camera->get_instance_id();
 	} else {
 		_camera_instance_id = 0;
-		set_process(false); // disable snapping
-		LOG(ERROR, "Cannot find the active camera. Set it manually with Terrain3D.set_camera(). Stopping _process()");
+		_snap_enabled = false; // _process() continues to finish saves
+		LOG(ERROR, "Cannot find the active camera. Set it manually with Terrain3D.set_camera(). Stopping snapping");
 	}
 }
 
@@ -145,14 +160,10 @@ void Terrain3D::_build_containers() {
 	_label_nodes = memnew(Node);
 	_label_nodes->set_name("Labels");
 	add_child(_label_nodes, true);
-	_mmi_nodes = memnew(Node);
-	_mmi_nodes->set_name("MMIs");
-	add_child(_mmi_nodes, true);
 }
 
 void Terrain3D::_destroy_containers() {
 	memdelete_safely(_label_nodes);
-	memdelete_safely(_mmi_nodes);
 }
 
 void Terrain3D::_destroy_labels() {
@@ -169,6 +180,10 @@ void Terrain3D::_setup_mouse_picking() {
 		LOG(ERROR, "Not inside the tree, skipping mouse setup");
 		return;
 	}
+	if (IS_HEADLESS) {
+		LOG(INFO, "Running headless, skipping mouse setup");
+		return;
+	}
 	LOG(INFO, "Setting up mouse picker and get_intersection viewport, camera & screen quad");
 	_mouse_vp = memnew(SubViewport);
 	_mouse_vp->set_name("MouseViewport");
@@ -233,6 +248,10 @@ void Terrain3D::_build_meshes(const int p_mesh_lods, const int p_mesh_size) {
 		LOG(DEBUG, "Not inside the tree or no valid _data, skipping build");
 		return;
 	}
+	if (IS_HEADLESS) {
+		LOG(INFO, "Running headless, skipping terrain meshes");
+		return;
+	}
 	LOG(INFO, "Building the terrain meshes");
 
 	// Generate terrain meshes, lods, seams
@@ -308,6 +327,7 @@ void Terrain3D::_build_meshes(const int p_mesh_lods, const int p_mesh_size) {
 /**
  * Make all mesh instances visible or not
  * Update all mesh instances with the new world scenario so they appear
+ * Instancer instances follow along, except for the cast shadows setting of their mesh asset
  */
 void Terrain3D::_update_mesh_instances() {
 	if (!_initialized || !_is_inside_world || !is_inside_tree()) {
@@ -317,6 +337,10 @@ void Terrain3D::_update_mesh_instances() {
 		RID _space = get_world_3d()->get_space();
 		PhysicsServer3D::get_singleton()->body_set_space(_static_body, _space);
 	}
+	if (_meshes.is_empty()) {
+		_instancer->_update_instance_settings();
+		return;
+	}
 
 	RID _scenario = get_world_3d()->get_scenario();
 
@@ -353,6 +377,8 @@ void Terrain3D::_update_mesh_instances() {
 		RS->instance_geometry_set_cast_shadows_setting(rid, RenderingServer::ShadowCastingSetting(_cast_shadows));
 		RS->instance_set_layer_mask(rid, _render_layers);
 	}
+
+	_instancer->_update_instance_settings();
 }
 
 void Terrain3D::_clear_meshes() {
@@ -360,7 +386,10 @@ void Terrain3D::_clear_meshes() {
 	for (const RID rid : _meshes) {
 		RS->free_rid(rid);
 	}
-	RS->free_rid(_mesh_data.cross);
+	if (_mesh_data.cross.is_valid()) {
+		RS->free_rid(_mesh_data.cross);
+		_mesh_data.cross = RID();
+	}
 	for (const RID rid : _mesh_data.tiles) {
 		RS->free_rid(rid);
 	}
@@ -549,6 +578,9 @@ void Terrain3D::_update_collision() {
 }
 
 void Terrain3D::_destroy_collision() {
+	if (_instancer != nullptr) {
+		_instancer->_destroy_collision();
+	}
 	if (_static_body.is_valid()) {
 		LOG(INFO, "Freeing physics body");
 		RID shape = PhysicsServer3D::get_singleton()->body_get_shape(_static_body, 0);
@@ -768,6 +800,36 @@ void Terrain3D::set_save_16_bit(const bool p_enabled) {
 	_save_16_bit = p_enabled;
 }
 
+void Terrain3D::set_save_raw(const bool p_enabled) {
+	LOG(INFO, p_enabled);
+	_save_raw = p_enabled;
+}
+
+void Terrain3D::set_save_raw_compression(const int p_compression) {
+	LOG(INFO, p_compression);
+	_save_raw_compression = CLAMP(p_compression, Terrain3DRegion::RAW_UNCOMPRESSED, int(FileAccess::COMPRESSION_GZIP));
+}
+
+void Terrain3D::set_runtime_16_bit(const bool p_enabled) {
+	LOG(INFO, p_enabled);
+	_runtime_16_bit = p_enabled;
+	if (_data) {
+		_data->update_height_format();
+	}
+}
+
+void Terrain3D::set_resident_maps(const int p_map_mask) {
+	int mask = p_map_mask & Terrain3DRegion::ALL_MAPS;
+	if (_resident_maps == mask) {
+		return;
+	}
+	LOG(INFO, mask);
+	_resident_maps = mask;
+	if (_data) {
+		_data->update_resident_maps();
+	}
+}
+
 void Terrain3D::set_material(const Ref<Terrain3DMaterial> &p_material) {
 	if (_material != p_material) {
 		_clear_meshes();
@@ -788,6 +850,12 @@ void Terrain3D::set_assets(const Ref<Terrain3DAssets> &p_assets) {
 	}
 }
 
+// Deprecated. Instances are drawn by RenderingServer instances, so there are no MMI nodes
+Node *Terrain3D::get_mmi_parent() const {
+	LOG(ERROR, "get_mmi_parent() is deprecated and returns null. Use Terrain3DInstancer.get_instance_rid()");
+	return nullptr;
+}
+
 void Terrain3D::set_editor(Terrain3DEditor *p_editor) {
 	_editor = p_editor;
 	LOG(DEBUG, "Received Terrain3DEditor: ", p_editor);
@@ -809,6 +877,7 @@ void Terrain3D::set_camera(Camera3D *p_camera) {
 			_camera_instance_id = _camera->get_instance_id();
 			LOG(DEBUG, "Setting camera: ", _camera);
 			_initialize();
+			_snap_enabled = true;
 			set_process(true); // enable __process snapping
 		}
 	}
@@ -930,6 +999,10 @@ RID Terrain3D::get_collision_rid() const {
  * Centers the terrain and LODs on a provided position. Y height is ignored.
  */
 void Terrain3D::snap(const Vector3 &p_cam_pos) {
+	if (_meshes.is_empty()) {
+		LOG(DEBUG, "Snap called before terrain meshes built. Returning.");
+		return;
+	}
 	Vector3 cam_pos = p_cam_pos;
 	cam_pos.y = 0;
 	LOG(DEBUG_CONT, "Snapping terrain to: ", String(cam_pos));
@@ -1056,6 +1129,10 @@ void Terrain3D::update_aabbs() {
  * Returns Vec3(NAN) on error or vec3(3.402823466e+38F) on no intersection. Test w/ if (var.x < 3.4e38)
  */
 Vector3 Terrain3D::get_intersection(const Vector3 &p_src_pos, const Vector3 &p_direction) {
+	if (IS_HEADLESS) {
+		LOG(ERROR, "No GPU depth texture when running headless. Use Terrain3DData.get_height() instead");
+		return Vector3(NAN, NAN, NAN);
+	}
 	if (!is_instance_valid(_camera_instance_id)) {
 		LOG(ERROR, "Invalid camera");
 		return Vector3(NAN, NAN, NAN);
@@ -1119,7 +1196,7 @@ void Terrain3D::set_show_region_labels(const bool p_enabled) {
 
 void Terrain3D::update_region_labels() {
 	_destroy_labels();
-	if (_show_region_labels && _data != nullptr) {
+	if (_show_region_labels && _data != nullptr && !IS_HEADLESS) {
 		Array region_locations = _data->get_region_locations();
 		LOG(DEBUG, "Creating ", region_locations.size(), " region labels");
 		for (int i = 0; i < region_locations.size(); i++) {
@@ -1305,6 +1382,7 @@ void Terrain3D::_notification(const int p_what) {
 			set_meta("_edit_lock_", true);
 			_setup_mouse_picking();
 			_initialize(); // Rebuild anything freed: meshes, collision, instancer
+			_snap_enabled = true;
 			set_process(true);
 			break;
 		}
@@ -1352,10 +1430,12 @@ void Terrain3D::_notification(const int p_what) {
 			} else if (_data == nullptr) {
 				LOG(DEBUG, "Save requested, but no valid data object. Skipping");
 			} else {
-				_data->save_directory(_data_directory);
+				_data->save_directory(_data_directory, true);
 			}
 			if (!_material.is_valid()) {
 				LOG(DEBUG, "Save requested, but no valid material. Skipping");
+			} else if (IS_HEADLESS) {
+				LOG(DEBUG, "Save requested, but the material isn't initialized when headless. Skipping");
 			} else {
 				_material->save();
 			}
@@ -1386,6 +1466,10 @@ void Terrain3D::_notification(const int p_what) {
 			// Sent on scene changes
 			LOG(INFO, "NOTIFICATION_EXIT_TREE");
 			set_process(false);
+			// Without _process(), an async save would never be finished
+			if (_data != nullptr && _data->_save.group_id >= 0) {
+				_data->_finish_save();
+			}
 			_clear_meshes();
 			_destroy_mouse_picking();
 			break;
@@ -1440,6 +1524,14 @@ void Terrain3D::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("get_data_directory"), &Terrain3D::get_data_directory);
 	ClassDB::bind_method(D_METHOD("set_save_16_bit", "enabled"), &Terrain3D::set_save_16_bit);
 	ClassDB::bind_method(D_METHOD("get_save_16_bit"), &Terrain3D::get_save_16_bit);
+	ClassDB::bind_method(D_METHOD("set_save_raw", "enabled"), &Terrain3D::set_save_raw);
+	ClassDB::bind_method(D_METHOD("get_save_raw"), &Terrain3D::get_save_raw);
+	ClassDB::bind_method(D_METHOD("set_save_raw_compression", "compression"), &Terrain3D::set_save_raw_compression);
+	ClassDB::bind_method(D_METHOD("get_save_raw_compression"), &Terrain3D::get_save_raw_compression);
+	ClassDB::bind_method(D_METHOD("set_runtime_16_bit", "enabled"), &Terrain3D::set_runtime_16_bit);
+	ClassDB::bind_method(D_METHOD("get_runtime_16_bit"), &Terrain3D::get_runtime_16_bit);
+	ClassDB::bind_method(D_METHOD("set_resident_maps", "map_mask"), &Terrain3D::set_resident_maps);
+	ClassDB::bind_method(D_METHOD("get_resident_maps"), &Terrain3D::get_resident_maps);
 
 	ClassDB::bind_method(D_METHOD("set_material", "material"), &Terrain3D::set_material);
 	ClassDB::bind_method(D_METHOD("get_material"), &Terrain3D::get_material);
@@ -1488,6 +1580,10 @@ void Terrain3D::_bind_methods() {
 	//ADD_PROPERTY(PropertyInfo(Variant::INT, "region_size", PROPERTY_HINT_ENUM, "64:64, 128:128, 256:256, 512:512, 1024:1024, 2048:2048"), "set_region_size", "get_region_size");
 	ADD_PROPERTY(PropertyInfo(Variant::INT, "region_size", PROPERTY_HINT_ENUM, "1024:1024"), "set_region_size", "get_region_size");
 	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "save_16_bit", PROPERTY_HINT_NONE), "set_save_16_bit", "get_save_16_bit");
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "runtime_16_bit", PROPERTY_HINT_NONE), "set_runtime_16_bit", "get_runtime_16_bit");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "resident_maps", PROPERTY_HINT_FLAGS, "Height,Control,Color"), "set_resident_maps", "get_resident_maps");
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "save_raw", PROPERTY_HINT_NONE), "set_save_raw", "get_save_raw");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "save_raw_compression", PROPERTY_HINT_ENUM, "None:-1,FastLZ:0,Deflate:1,Zstd:2,GZip:3"), "set_save_raw_compression", "get_save_raw_compression");
 	ADD_PROPERTY(PropertyInfo(Variant::OBJECT, "material", PROPERTY_HINT_RESOURCE_TYPE, "Terrain3DMaterial"), "set_material", "get_material");
 	ADD_PROPERTY(PropertyInfo(Variant::OBJECT, "assets", PROPERTY_HINT_RESOURCE_TYPE, "Terrain3DAssets"), "set_assets", "get_assets");
 	ADD_PROPERTY(PropertyInfo(Variant::OBJECT, "data", PROPERTY_HINT_NONE, "Terrain3DData", PROPERTY_USAGE_NONE), "", "get_data");
@@ -48,6 +48,10 @@ private:
 	real_t _mesh_vertex_spacing = 1.0f;
 	String _data_directory;
 	bool _save_16_bit = false;
+	bool _save_raw = false;
+	int _save_raw_compression = Terrain3DRegion::RAW_UNCOMPRESSED;
+	bool _runtime_16_bit = false;
+	int _resident_maps = Terrain3DRegion::ALL_MAPS;
 	bool _show_region_labels = false;
 
 	Terrain3DData *_data = nullptr;
@@ -58,7 +62,6 @@ private:
 
 	// Parent containers for child nodes
 	Node *_label_nodes;
-	Node *_mmi_nodes;
 
 	// Editor components
 	EditorPlugin *_plugin = nullptr;
@@ -66,6 +69,8 @@ private:
 	Camera3D *_camera = nullptr;
 	uint64_t _camera_instance_id = 0;
 
+	// Cleared if no camera is found, so _process() keeps finishing saves without snapping
+	bool _snap_enabled = true;
 	// X,Z Position of the camera during the previous snapping. Set to max real_t value to force a snap update.
 	Vector2 _camera_last_position = V2_MAX;
 
@@ -149,6 +154,14 @@ public:
 	String get_data_directory() const;
 	void set_save_16_bit(const bool p_enabled);
 	bool get_save_16_bit() const { return _save_16_bit; }
+	void set_save_raw(const bool p_enabled);
+	bool get_save_raw() const { return _save_raw; }
+	void set_save_raw_compression(const int p_compression);
+	int get_save_raw_compression() const { return _save_raw_compression; }
+	void set_runtime_16_bit(const bool p_enabled);
+	bool get_runtime_16_bit() const { return _runtime_16_bit; }
+	void set_resident_maps(const int p_map_mask);
+	int get_resident_maps() const { return _resident_maps; }
 
 	void set_material(const Ref<Terrain3DMaterial> &p_material);
 	Ref<Terrain3DMaterial> get_material() const { return _material; }
@@ -157,7 +170,7 @@ public:
 
 	// Instancer
 	Terrain3DInstancer *get_instancer() const { return _instancer; }
-	Node *get_mmi_parent() const { return _mmi_nodes; }
+	Node *get_mmi_parent() const; // Deprecated
 
 	// Editor components
 	void set_editor(Terrain3DEditor *p_editor);
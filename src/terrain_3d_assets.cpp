@@ -1,5 +1,6 @@
 // Copyright © 2024 Cory Petkovsek, Roope Palmroos, and Contributors.
 
+#include <godot_cpp/classes/display_server.hpp>
 #include <godot_cpp/classes/environment.hpp>
 #include <godot_cpp/classes/image_texture.hpp>
 #include <godot_cpp/classes/rendering_server.hpp>
@@ -162,6 +163,12 @@ void Terrain3DAssets::_update_texture_files() {
 		emit_signal("textures_changed");
 		return;
 	}
+	// A headless server has no material to sample the texture arrays
+	if (IS_HEADLESS) {
+		LOG(DEBUG, "Running headless, skipping texture arrays");
+		emit_signal("textures_changed");
+		return;
+	}
 
 	// Detect image sizes and formats
 
@@ -324,7 +331,12 @@ void Terrain3DAssets::_update_thumbnail(const Ref<Terrain3DMeshAsset> &p_mesh_as
 void Terrain3DAssets::initialize(Terrain3D *p_terrain) {
 	_terrain = p_terrain;
 
-	// Setup Mesh preview environment
+	// Setup Mesh preview environment, unless headless where thumbnails can't be drawn
+	if (IS_HEADLESS) {
+		update_texture_list();
+		update_mesh_list();
+		return;
+	}
 	scenario = RS->scenario_create();
 
 	viewport = RS->viewport_create();
@@ -360,6 +372,9 @@ void Terrain3DAssets::initialize(Terrain3D *p_terrain) {
 Terrain3DAssets::~Terrain3DAssets() {
 	_generated_albedo_textures.clear();
 	_generated_normal_textures.clear();
+	if (!scenario.is_valid()) {
+		return;
+	}
 	RS->free_rid(mesh_instance);
 	RS->free_rid(fill_light_instance);
 	RS->free_rid(fill_light);
@@ -433,6 +448,10 @@ void Terrain3DAssets::set_mesh_list(const TypedArray<Terrain3DMeshAsset> &p_mesh
 // p_id = -1 for all meshes
 // Adapted from godot\editor\plugins\editor_preview_plugins.cpp:EditorMeshPreviewPlugin
 void Terrain3DAssets::create_mesh_thumbnails(const int p_id, const Vector2i &p_size) {
+	if (!viewport.is_valid()) {
+		LOG(DEBUG, "No preview viewport, skipping thumbnails");
+		return;
+	}
 	int start, end;
 	int max = get_mesh_count();
 	if (p_id < 0) {
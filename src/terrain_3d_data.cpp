@@ -1,14 +1,18 @@
 // Copyright © 2024 Cory Petkovsek, Roope Palmroos, and Contributors.
 
 #include <godot_cpp/classes/dir_access.hpp>
+#include <godot_cpp/classes/display_server.hpp>
 #include <godot_cpp/classes/editor_file_system.hpp>
 #include <godot_cpp/classes/editor_interface.hpp>
 #include <godot_cpp/classes/engine.hpp>
 #include <godot_cpp/classes/file_access.hpp>
+#include <godot_cpp/classes/project_settings.hpp>
 #include <godot_cpp/classes/resource_saver.hpp>
+#include <godot_cpp/classes/worker_thread_pool.hpp>
 
 #include "logger.h"
 #include "terrain_3d_data.h"
+#include "terrain_3d_util.h"
 
 ///////////////////////////
 // Private Functions
@@ -24,12 +28,477 @@ void Terrain3DData::_clear() {
 	_generated_height_maps.clear();
 	_generated_control_maps.clear();
 	_generated_color_maps.clear();
+	for (Ref<Image> &blank : _blank_maps) {
+		blank.unref();
+	}
+}
+
+// Points the blank maps of a region at one shared copy of their pixels. Images copy their data on
+// the first write, so the region gets its own copy again when painted.
+void Terrain3DData::_share_blank_maps(const Ref<Terrain3DRegion> &p_region) {
+	for (int i = 0; i < TYPE_MAX; i++) {
+		MapType type = MapType(i);
+		Ref<Image> map = p_region->get_map(type);
+		Ref<Image> &blank = _blank_maps[i];
+		bool match = blank.is_valid() && map.is_valid() && blank->get_size() == map->get_size() &&
+				blank->get_format() == map->get_format() && blank->has_mipmaps() == map->has_mipmaps();
+		if (match && map->get_data().ptr() == blank->get_data().ptr()) {
+			continue;
+		}
+		if (!p_region->is_blank(type)) {
+			continue;
+		}
+		if (match) {
+			map->set_data(map->get_width(), map->get_height(), map->has_mipmaps(), map->get_format(), blank->get_data());
+		} else {
+			blank.instantiate();
+			blank->copy_from(map);
+		}
+	}
+}
+
+// Returns the global pixel rect covering an area, clipped to the world bounds
+Rect2i Terrain3DData::_get_pixel_rect(const AABB &p_area) const {
+	Vector2i start = Vector2i((Vector2(p_area.position.x, p_area.position.z) / _mesh_vertex_spacing).floor());
+	Vector2i end = Vector2i((Vector2(p_area.get_end().x, p_area.get_end().z) / _mesh_vertex_spacing).ceil());
+	int half_world = _region_size * REGION_MAP_SIZE / 2;
+	Rect2i world = Rect2i(-half_world, -half_world, half_world * 2, half_world * 2);
+	return Rect2i(start, end - start).intersection(world);
+}
+
+// Returns the global area covered by a global pixel rect, spanning the full height range
+AABB Terrain3DData::_get_pixel_area(const Rect2i &p_rect) const {
+	AABB area;
+	area.position = Vector3(p_rect.position.x * _mesh_vertex_spacing, _master_height_range.x, p_rect.position.y * _mesh_vertex_spacing);
+	area.size = Vector3(p_rect.size.x * _mesh_vertex_spacing, _master_height_range.y - _master_height_range.x, p_rect.size.y * _mesh_vertex_spacing);
+	return area;
+}
+
+// Copies the heights within a global pixel rect to p_heights, NAN where there is no active region
+void Terrain3DData::_copy_heights(const Rect2i &p_rect, float *p_heights) const {
+	for (int y = 0; y < p_rect.size.y; y++) {
+		int x = 0;
+		while (x < p_rect.size.x) {
+			Vector2i pixel = p_rect.position + Vector2i(x, y);
+			Vector2i region_loc = Vector2i((Vector2(pixel) / real_t(_region_size)).floor());
+			// Copy the row up to the edge of this region
+			int count = MIN(p_rect.size.x - x, (region_loc.x + 1) * _region_size - pixel.x);
+			float *row = p_heights + y * p_rect.size.x + x;
+			if (has_region(region_loc)) {
+				Ref<Terrain3DRegion> region = _regions[region_loc];
+				Vector2i img_pos = pixel - region_loc * _region_size;
+				Ref<Image> height_map = region->get_height_map();
+				get_height_values(height_map->ptr(), is_half_height(height_map), img_pos.y * _region_size + img_pos.x, row, count);
+			} else {
+				for (int i = 0; i < count; i++) {
+					row[i] = NAN;
+				}
+			}
+			x += count;
+		}
+	}
+}
+
+// Writes the heights within a global pixel rect to the active regions, skipping NAN. Updates the
+// height ranges and marks the regions modified. Returns the locations of the regions written.
+TypedArray<Vector2i> Terrain3DData::_paste_heights(const Rect2i &p_rect, const float *p_heights) {
+	TypedArray<Vector2i> region_locs;
+	Vector2i loc_min = Vector2i((Vector2(p_rect.position) / real_t(_region_size)).floor());
+	Vector2i loc_max = Vector2i((Vector2(p_rect.get_end() - Vector2i(1, 1)) / real_t(_region_size)).floor());
+	for (int ly = loc_min.y; ly <= loc_max.y; ly++) {
+		for (int lx = loc_min.x; lx <= loc_max.x; lx++) {
+			Vector2i region_loc = Vector2i(lx, ly);
+			if (!has_region(region_loc)) {
+				continue;
+			}
+			Ref<Terrain3DRegion> region = _regions[region_loc];
+			region->load_maps(1 << TYPE_HEIGHT);
+			Vector2i region_offset = region_loc * _region_size;
+			Rect2i area = p_rect.intersection(Rect2i(region_offset, _region_sizev));
+			Ref<Image> height_map = region->get_height_map();
+			uint8_t *dst = height_map->ptrw();
+			const bool half = is_half_height(height_map);
+			Vector2 height_range = Vector2(FLT_MAX, -FLT_MAX);
+			for (int y = area.position.y; y < area.get_end().y; y++) {
+				const float *src_row = p_heights + (y - p_rect.position.y) * p_rect.size.x - p_rect.position.x;
+				int64_t dst_row = int64_t(y - region_offset.y) * _region_size - region_offset.x;
+				for (int x = area.position.x; x < area.get_end().x; x++) {
+					float height = src_row[x];
+					if (std::isnan(height)) {
+						continue;
+					}
+					set_height_value(dst, half, dst_row + x, height);
+					height_range.x = MIN(height_range.x, height);
+					height_range.y = MAX(height_range.y, height);
+				}
+			}
+			if (height_range.x <= height_range.y) {
+				region->update_heights(height_range);
+				update_master_heights(height_range);
+			}
+			region->mark_dirty(TYPE_HEIGHT, Rect2i(area.position - region_offset, area.size));
+			region_locs.push_back(region_loc);
+		}
+	}
+	return region_locs;
+}
+
+// Simulates the droplets starting in one tile. Droplets may travel into a halo around the tile
+// up to their lifetime. Tiles processed at the same time are one tile apart, so no two threads
+// write to the same pixels, and the results don't depend on thread timing.
+void Terrain3DData::_erode_hydraulic_tile(const uint32_t p_index) {
+	ErosionJob &job = _erosion;
+	const Vector2i tile = job.phase_tiles[p_index];
+	const int width = job.rect.size.x;
+	const int height = job.rect.size.y;
+	float *heights = job.heights;
+
+	Vector2i tile_start = tile * EROSION_TILE_SIZE;
+	Vector2i tile_end = Vector2i(MIN(tile_start.x + EROSION_TILE_SIZE, width), MIN(tile_start.y + EROSION_TILE_SIZE, height));
+	int halo = job.lifetime + 2;
+	Vector2i window_start = Vector2i(MAX(tile_start.x - halo, 0), MAX(tile_start.y - halo, 0));
+	Vector2i window_end = Vector2i(MIN(tile_end.x + halo, width), MIN(tile_end.y + halo, height));
+	Vector2 tile_size = Vector2(tile_end - tile_start);
+
+	int droplets = int(job.droplet_density * tile_size.x * tile_size.y);
+	uint32_t state = hash32(job.seed ^ hash32(job.iteration * job.tiles.x * job.tiles.y + tile.y * job.tiles.x + tile.x));
+
+	for (int d = 0; d < droplets; d++) {
+		Vector2 pos = Vector2(tile_start) + Vector2(rand_float(state), rand_float(state)) * tile_size;
+		Vector2 dir = V2_ZERO;
+		real_t speed = 1.f;
+		real_t water = 1.f;
+		real_t sediment = 0.f;
+
+		for (int life = 0; life < job.lifetime; life++) {
+			// Bilinear height and gradient at the droplet position
+			int x0 = int(pos.x);
+			int y0 = int(pos.y);
+			if (x0 < window_start.x || y0 < window_start.y || x0 + 1 >= window_end.x || y0 + 1 >= window_end.y) {
+				break;
+			}
+			float *cell = heights + y0 * width + x0;
+			real_t h00 = cell[0], h10 = cell[1], h01 = cell[width], h11 = cell[width + 1];
+			if (std::isnan(h00) || std::isnan(h10) || std::isnan(h01) || std::isnan(h11)) {
+				break;
+			}
+			real_t u = pos.x - x0;
+			real_t v = pos.y - y0;
+			real_t h = Math::lerp(Math::lerp(h00, h10, u), Math::lerp(h01, h11, u), v);
+			Vector2 gradient = Vector2((h10 - h00) * (1.f - v) + (h11 - h01) * v,
+					(h01 - h00) * (1.f - u) + (h11 - h10) * u);
+
+			// Move downhill, keeping some of the previous direction
+			dir = dir * job.inertia - gradient * (1.f - job.inertia);
+			if (dir.length_squared() < CMP_EPSILON2) {
+				break;
+			}
+			dir.normalize();
+			Vector2 new_pos = pos + dir;
+			int nx0 = int(new_pos.x);
+			int ny0 = int(new_pos.y);
+			if (nx0 < window_start.x || ny0 < window_start.y || nx0 + 1 >= window_end.x || ny0 + 1 >= window_end.y) {
+				break;
+			}
+			const float *new_cell = heights + ny0 * width + nx0;
+			real_t nu = new_pos.x - nx0;
+			real_t nv = new_pos.y - ny0;
+			real_t new_h = Math::lerp(Math::lerp(real_t(new_cell[0]), real_t(new_cell[1]), nu),
+					Math::lerp(real_t(new_cell[width]), real_t(new_cell[width + 1]), nu), nv);
+			if (std::isnan(new_h)) {
+				break;
+			}
+
+			// Deposit when over capacity or moving uphill, otherwise erode
+			real_t delta_h = new_h - h;
+			real_t capacity = MAX(-delta_h * speed * water * job.capacity, job.min_capacity);
+			real_t amount;
+			if (sediment > capacity || delta_h > 0.f) {
+				amount = (delta_h > 0.f) ? MIN(delta_h, sediment) : (sediment - capacity) * job.deposit_speed;
+				sediment -= amount;
+			} else {
+				amount = -MIN((capacity - sediment) * job.erode_speed, -delta_h);
+				sediment -= amount;
+			}
+			cell[0] += amount * (1.f - u) * (1.f - v);
+			cell[1] += amount * u * (1.f - v);
+			cell[width] += amount * (1.f - u) * v;
+			cell[width + 1] += amount * u * v;
+
+			speed = Math::sqrt(MAX(speed * speed - delta_h * job.gravity, 0.f));
+			water *= 1.f - job.evaporate_speed;
+			pos = new_pos;
+		}
+	}
+}
+
+// Moves material from each pixel to neighbors lower than the talus angle allows, and from higher
+// neighbors to it. Reads from heights and writes to scratch, so rows are independent.
+void Terrain3DData::_erode_thermal_row(const uint32_t p_row) {
+	const ErosionJob &job = _erosion;
+	const int width = job.rect.size.x;
+	const int height = job.rect.size.y;
+	const int y = p_row;
+	static const int offsets[8][2] = { { -1, -1 }, { 0, -1 }, { 1, -1 }, { -1, 0 }, { 1, 0 }, { -1, 1 }, { 0, 1 }, { 1, 1 } };
+	static const real_t distances[8] = { Math_SQRT2, 1.f, Math_SQRT2, 1.f, 1.f, Math_SQRT2, 1.f, Math_SQRT2 };
+
+	const float *src = job.heights;
+	float *dst = job.scratch + y * width;
+	for (int x = 0; x < width; x++) {
+		real_t center = src[y * width + x];
+		if (std::isnan(center)) {
+			dst[x] = center;
+			continue;
+		}
+		real_t delta = 0.f;
+		for (int n = 0; n < 8; n++) {
+			int nx = x + offsets[n][0];
+			int ny = y + offsets[n][1];
+			if (nx < 0 || ny < 0 || nx >= width || ny >= height) {
+				continue;
+			}
+			real_t neighbor = src[ny * width + nx];
+			if (std::isnan(neighbor)) {
+				continue;
+			}
+			real_t talus = job.talus * distances[n];
+			real_t diff = center - neighbor;
+			if (diff > talus) {
+				delta -= diff - talus;
+			} else if (-diff > talus) {
+				delta += -diff - talus;
+			}
+		}
+		// Each pair moves the same amount in opposite directions, so material is conserved
+		dst[x] = center + delta * job.thermal_strength * .125f;
+	}
+}
+
+// Returns fBm or ridged noise at p_pos, normalized to about -1 to 1 or 0 to 1 respectively
+real_t Terrain3DData::_get_fractal_noise(const Vector2 &p_pos, const uint32_t p_seed, const int p_octaves) const {
+	const GenerateJob &job = _generate;
+	real_t sum = 0.f;
+	real_t amplitude = 1.f;
+	real_t total_amplitude = 0.f;
+	Vector2 pos = p_pos;
+	for (int i = 0; i < p_octaves; i++) {
+		real_t n = gradient_noise(pos, p_seed + i);
+		if (job.ridged) {
+			n = 1.f - Math::abs(n);
+			n *= n;
+		}
+		sum += n * amplitude;
+		total_amplitude += amplitude;
+		amplitude *= job.gain;
+		pos *= job.lacunarity;
+	}
+	return (total_amplitude > 0.f) ? sum / total_amplitude : 0.f;
+}
+
+// Writes noise to the pixels of one tile. Tiles never share pixels.
+void Terrain3DData::_generate_tile(const uint32_t p_index) {
+	const GenerateJob &job = _generate;
+	GenerateTile &tile = _generate.tiles[p_index];
+	Vector2i region_offset = tile.region_loc * _region_size;
+	Vector2 height_range = Vector2(FLT_MAX, -FLT_MAX);
+	for (int y = tile.rect.position.y; y < tile.rect.get_end().y; y++) {
+		int64_t row = int64_t(y - region_offset.y) * _region_size - region_offset.x;
+		for (int x = tile.rect.position.x; x < tile.rect.get_end().x; x++) {
+			Vector2 pos = Vector2(x, y) * _mesh_vertex_spacing * job.frequency;
+			// Domain warping offsets the lookup by two more noise fields
+			if (job.warp_strength > 0.f) {
+				Vector2 warp_pos = pos * job.warp_frequency;
+				Vector2 warp = Vector2(gradient_noise(warp_pos, job.seed ^ 0x5bd1e995U),
+						gradient_noise(warp_pos + Vector2(5.2f, 1.3f), job.seed ^ 0x1b873593U));
+				pos += warp * job.warp_strength;
+			}
+			real_t height = _get_fractal_noise(pos, job.seed, job.octaves) * job.height + job.offset;
+			if (job.additive) {
+				height += get_height_value(tile.map, tile.half, row + x);
+			}
+			set_height_value(tile.map, tile.half, row + x, height);
+			height_range.x = MIN(height_range.x, height);
+			height_range.y = MAX(height_range.y, height);
+		}
+	}
+	tile.height_range = height_range;
+}
+
+// Returns true if a source of p_size imported at p_global_position fits within the world
+bool Terrain3DData::_check_import_size(const Vector2i &p_size, const Vector3 &p_global_position) const {
+	Vector3 descaled_position = p_global_position / _mesh_vertex_spacing;
+	int max_dimension = _region_size * REGION_MAP_SIZE / 2;
+	if ((abs(descaled_position.x) > max_dimension) || (abs(descaled_position.z) > max_dimension)) {
+		LOG(ERROR, "Specify a position within +/-", Vector3(max_dimension, 0.f, max_dimension) * _mesh_vertex_spacing);
+		return false;
+	}
+	if ((descaled_position.x + p_size.x > max_dimension) ||
+			(descaled_position.z + p_size.y > max_dimension)) {
+		LOG(ERROR, p_size, " image will not fit at ", p_global_position,
+				". Try ", -(p_size * _mesh_vertex_spacing) / 2.f, " to center");
+		return false;
+	}
+	return true;
+}
+
+// Builds the region of one import slice from the source images or r16 strip, padding any remainder
+void Terrain3DData::_import_slice(const uint32_t p_index) {
+	const ImportJob &job = _import;
+	ImportSlice &slice = _import.slices[p_index];
+	TypedArray<Image> maps;
+	maps.resize(TYPE_MAX);
+	for (int i = 0; i < TYPE_MAX; i++) {
+		Ref<Image> src = job.images[i];
+		Ref<Image> map;
+		if (i == TYPE_HEIGHT && job.strip != nullptr) {
+			map = Util::get_filled_image(_region_sizev, COLOR[i], false, FORMAT[i]);
+			float *heights = reinterpret_cast<float *>(map->ptrw());
+			for (int y = 0; y < slice.size.y; y++) {
+				const uint8_t *row = job.strip + (int64_t(y) * job.strip_width + slice.start.x) * 2;
+				r16_to_heights(row, heights + int64_t(y) * _region_size, slice.size.x, job.scale, job.offset);
+			}
+		} else if (src.is_valid() && !src->is_empty()) {
+			map = Util::get_filled_image(_region_sizev, COLOR[i], false, src->get_format());
+			map->blit_rect(src, Rect2i(slice.start, slice.size), V2I_ZERO);
+			// Scale only the copied pixels, leaving the padding at the default height
+			if (i == TYPE_HEIGHT && (job.offset != 0.f || job.scale != 1.f)) {
+				if (map->get_format() != FORMAT[i]) {
+					map->convert(FORMAT[i]);
+				}
+				float *heights = reinterpret_cast<float *>(map->ptrw());
+				for (int y = 0; y < slice.size.y; y++) {
+					float *row = heights + int64_t(y) * _region_size;
+					for (int x = 0; x < slice.size.x; x++) {
+						row[x] = row[x] * job.scale + job.offset;
+					}
+				}
+			}
+		} else {
+			map = Util::get_filled_image(_region_sizev, COLOR[i], false, FORMAT[i]);
+		}
+		maps[i] = map;
+	}
+	Ref<Terrain3DRegion> region;
+	region.instantiate();
+	Vector3 position = Vector3(job.position.x + slice.start.x, 0.f, job.position.z + slice.start.y);
+	region->set_location(get_region_location(position * _mesh_vertex_spacing));
+	region->set_maps(maps);
+	slice.region = region;
+}
+
+// Writes one region snapshot to its temporary file, or updates its raw file in place with only the
+// changed chunks. Runs on the WorkerThreadPool. The snapshot is only used by this task, so it can be
+// converted in place.
+void Terrain3DData::_save_region_task(const uint32_t p_index) {
+	SaveItem &item = _save.items[p_index];
+	if (_save.save_raw) {
+		item.error = item.snapshot->update_raw(item.abs_path, _save.save_16_bit, _save.raw_compression);
+		item.in_place = item.error != ERR_UNAVAILABLE;
+		if (!item.in_place) {
+			item.error = item.snapshot->save_raw(item.temp_path, _save.save_16_bit, _save.raw_compression);
+		}
+	} else {
+		if (_save.save_16_bit) {
+			Ref<Image> height_map = item.snapshot->get_height_map();
+			if (height_map.is_valid()) {
+				height_map->convert(Image::FORMAT_RH);
+			}
+		}
+		item.error = ResourceSaver::get_singleton()->save(item.snapshot, item.temp_path, ResourceSaver::FLAG_COMPRESS);
+	}
+	_save.completed.increment();
+}
+
+// Reads one raw region file. Runs on the WorkerThreadPool.
+void Terrain3DData::_load_region_task(const uint32_t p_index) {
+	LoadItem &item = _load_items[p_index];
+	item.region = Terrain3DRegion::load_raw(item.path, _terrain->get_resident_maps());
+}
+
+// Returns the path of the region file in either format
+String Terrain3DData::_get_region_path(const String &p_dir, const Vector2i &p_region_loc, const bool p_raw) const {
+	String fname = Util::location_to_filename(p_region_loc);
+	if (p_raw) {
+		fname = fname.get_basename() + "." + Terrain3DRegion::RAW_EXTENSION;
+	}
+	return p_dir + String("/") + fname;
+}
+
+// Reports progress of an async save, and finishes it once all regions are written
+// Called by Terrain3D::__process()
+void Terrain3DData::_update_save() {
+	if (_save.group_id < 0) {
+		return;
+	}
+	uint32_t completed = _save.completed.get();
+	if (completed != _save.reported) {
+		_save.reported = completed;
+		emit_signal("save_progress", completed, _save.items.size());
+	}
+	if (WorkerThreadPool::get_singleton()->is_group_task_completed(_save.group_id)) {
+		_finish_save();
+	}
+}
+
+// Waits for the save tasks, then moves the temporary files over the region files on the main thread
+void Terrain3DData::_finish_save() {
+	if (_save.group_id >= 0) {
+		WorkerThreadPool::get_singleton()->wait_for_group_task_completion(_save.group_id);
+		_save.group_id = -1;
+	}
+	int errors = 0;
+	bool is_editor = Engine::get_singleton()->is_editor_hint() && EditorInterface::get_singleton() != nullptr;
+	for (SaveItem &item : _save.items) {
+		if (item.error == OK && !item.in_place) {
+			item.error = DirAccess::rename_absolute(item.temp_path, item.abs_path);
+		}
+		if (item.error != OK) {
+			LOG(ERROR, "Cannot save region file: ", item.path, ". Error code: ", item.error, ". Look up @GlobalScope Error enum in the Godot docs");
+			if (!item.in_place) {
+				DirAccess::remove_absolute(item.temp_path);
+			}
+			// The file no longer matches the changes tracked since, so all of it is saved next time
+			item.region->mark_dirty();
+			errors++;
+			continue;
+		}
+		if (item.region->get_path() != item.path) {
+			item.region->take_over_path(item.path);
+		}
+		item.region->set_version(CURRENT_VERSION);
+		// Remove the file in the other format so it isn't loaded instead
+		String other_path = _get_region_path(item.path.get_base_dir(), item.region->get_location(), !_save.save_raw);
+		if (FileAccess::file_exists(other_path)) {
+			LOG(INFO, "Removing ", other_path, " replaced by ", item.path);
+			DirAccess::remove_absolute(ProjectSettings::get_singleton()->globalize_path(other_path));
+			if (is_editor) {
+				EditorInterface::get_singleton()->get_resource_filesystem()->update_file(other_path);
+			}
+		}
+		if (is_editor) {
+			EditorInterface::get_singleton()->get_resource_filesystem()->update_file(item.path);
+		}
+	}
+	LOG(INFO, "Saved ", _save.items.size() - errors, " regions, ", errors, " errors");
+	if (_save.reported != _save.items.size()) {
+		_save.reported = _save.items.size();
+		emit_signal("save_progress", _save.items.size(), _save.items.size());
+	}
+	_save.items.clear();
+	emit_signal("save_finished", errors);
 }
 
 ///////////////////////////
 // Public Functions
 ///////////////////////////
 
+Terrain3DData::~Terrain3DData() {
+	if (_save.group_id >= 0) {
+		_finish_save();
+	}
+	_clear();
+}
+
 void Terrain3DData::initialize(Terrain3D *p_terrain) {
 	if (p_terrain == nullptr) {
 		LOG(ERROR, "Initialization failed, p_terrain is null");
@@ -42,6 +511,7 @@ void Terrain3DData::initialize(Terrain3D *p_terrain) {
 	_mesh_vertex_spacing = _terrain->get_mesh_vertex_spacing();
 	_region_size = _terrain->get_region_size();
 	_region_sizev = Vector2i(_region_size, _region_size);
+	update_height_format();
 
 	if (!initialized && !_terrain->get_data_directory().is_empty()) {
 		load_directory(_terrain->get_data_directory());
@@ -74,7 +544,12 @@ void Terrain3DData::set_region_modified(const Vector2i &p_region_loc, const bool
 		LOG(ERROR, "Region not found at: ", p_region_loc);
 		return;
 	}
-	return region->set_modified(p_modified);
+	// Callers don't say what changed, so the whole region is saved
+	if (p_modified) {
+		region->mark_dirty();
+	} else {
+		region->set_modified(false);
+	}
 }
 
 bool Terrain3DData::is_region_modified(const Vector2i &p_region_loc) const {
@@ -139,6 +614,7 @@ Error Terrain3DData::add_region(const Ref<Terrain3DRegion> &p_region, const bool
 		return FAILED;
 	}
 	p_region->sanitize_maps();
+	_share_blank_maps(p_region);
 	p_region->set_deleted(false);
 	if (!_region_locations.has(region_loc)) {
 		_region_locations.push_back(region_loc);
@@ -189,11 +665,70 @@ void Terrain3DData::remove_region(const Ref<Terrain3DRegion> &p_region, const bo
 	}
 }
 
-void Terrain3DData::save_directory(const String &p_dir) {
+/**
+ * Saves modified regions in parallel and removes deleted region files.
+ * Each modified region is copied w/ Terrain3DRegion::get_save_snapshot(), then serialized and
+ * compressed on the WorkerThreadPool into a temporary file, which is renamed over the region file
+ * once written, so an interrupted save never leaves a partial file.
+ * If async, returns immediately and finishes in Terrain3D's process, emitting save_progress and
+ * save_finished. Otherwise waits for all regions, and emits the same signals before returning.
+ */
+void Terrain3DData::save_directory(const String &p_dir, const bool p_async) {
+	if (_save.group_id >= 0) {
+		LOG(INFO, "Waiting for the previous save to finish");
+		_finish_save();
+	}
 	LOG(INFO, "Saving data files to ", p_dir);
+	String abs_dir = ProjectSettings::get_singleton()->globalize_path(p_dir);
+	_save.items.clear();
+	_save.save_16_bit = _terrain->get_save_16_bit();
+	_save.save_raw = _terrain->get_save_raw();
+	_save.raw_compression = _terrain->get_save_raw_compression();
+	_save.completed.set(0);
+	_save.reported = 0;
 	Array locations = _regions.keys();
 	for (int i = 0; i < locations.size(); i++) {
-		save_region(locations[i], p_dir, _terrain->get_save_16_bit());
+		Ref<Terrain3DRegion> region = _regions[locations[i]];
+		if (region.is_null()) {
+			continue;
+		}
+		// Deleted regions are removed now
+		if (region->is_deleted()) {
+			save_region(locations[i], p_dir, _save.save_16_bit);
+			continue;
+		}
+		if (!region->is_modified()) {
+			LOG(DEBUG, "Region ", locations[i], " not modified. Skipping");
+			continue;
+		}
+		// Maps left out by Terrain3D.resident_maps are read back, so they aren't saved as blanks
+		if (region->load_maps() != OK) {
+			LOG(ERROR, "Cannot read unloaded maps of region ", locations[i], ". Skipping");
+			continue;
+		}
+		SaveItem item;
+		item.region = region;
+		item.snapshot = region->get_save_snapshot();
+		item.path = _get_region_path(p_dir, locations[i], _save.save_raw);
+		item.abs_path = abs_dir + String("/") + item.path.get_file();
+		item.temp_path = abs_dir + String("/.tmp-") + item.path.get_file();
+		_save.items.push_back(item);
+		// Edits made during the save mark it modified and dirty again
+		region->set_modified(false);
+		region->clear_dirty();
+	}
+	if (_save.items.is_empty()) {
+		emit_signal("save_finished", 0);
+		return;
+	}
+
+	LOG(MESG, "Writing ", _save.items.size(), (_save.save_16_bit) ? " 16-bit" : "", " regions to ", p_dir);
+	Callable task = callable_mp(this, &Terrain3DData::_save_region_task);
+	if (p_async) {
+		_save.group_id = WorkerThreadPool::get_singleton()->add_group_task(task, _save.items.size(), -1, false, "Terrain3DData save");
+	} else {
+		Util::run_group_task(task, _save.items.size(), "Terrain3DData save");
+		_finish_save();
 	}
 }
 
@@ -203,33 +738,69 @@ void Terrain3DData::save_region(const Vector2i &p_region_loc, const String &p_di
 		LOG(ERROR, "No region found at: ", p_region_loc);
 		return;
 	}
-	String fname = Util::location_to_filename(p_region_loc);
-	String path = p_dir + String("/") + fname;
+	bool raw = _terrain != nullptr && _terrain->get_save_raw();
+	int compression = (_terrain != nullptr) ? _terrain->get_save_raw_compression() : Terrain3DRegion::RAW_UNCOMPRESSED;
+	String path = _get_region_path(p_dir, p_region_loc, raw);
 	// If region marked for deletion, remove from disk and from _regions, but don't free in case stored in undo
 	if (region->is_deleted()) {
 		LOG(DEBUG, "Removing ", p_region_loc, " from _regions");
 		_regions.erase(p_region_loc);
-		LOG(DEBUG, "File to be deleted: ", path);
-		if (!FileAccess::file_exists(path)) {
-			LOG(INFO, "File to delete ", path, " doesn't exist. (Maybe from add, undo, save)");
-			return;
-		}
-		Ref<DirAccess> da = DirAccess::open(p_dir);
-		if (da.is_null()) {
-			LOG(ERROR, "Cannot open directory for writing: ", p_dir, " error: ", DirAccess::get_open_error());
-			return;
+		Ref<DirAccess> da;
+		// Files of either format
+		for (int i = 0; i < 2; i++) {
+			path = _get_region_path(p_dir, p_region_loc, i == 1);
+			LOG(DEBUG, "File to be deleted: ", path);
+			if (!FileAccess::file_exists(path)) {
+				LOG(INFO, "File to delete ", path, " doesn't exist. (Maybe from add, undo, save)");
+				continue;
+			}
+			if (da.is_null()) {
+				da = DirAccess::open(p_dir);
+				if (da.is_null()) {
+					LOG(ERROR, "Cannot open directory for writing: ", p_dir, " error: ", DirAccess::get_open_error());
+					return;
+				}
+			}
+			da->remove(path.get_file());
+			LOG(INFO, "File ", path, " deleted");
 		}
-		da->remove(fname);
-		if (Engine::get_singleton()->is_editor_hint()) {
+		if (da.is_valid() && Engine::get_singleton()->is_editor_hint()) {
 			EditorInterface::get_singleton()->get_resource_filesystem()->scan();
 		}
-		LOG(INFO, "File ", path, " deleted");
 		return;
 	}
-	region->save(path, p_16_bit);
+	// Read back unloaded maps from the current file before following the new format
+	if (region->load_maps() != OK) {
+		LOG(ERROR, "Cannot read unloaded maps of region ", p_region_loc, ". Skipping");
+		return;
+	}
+	// Follow the format if it has changed since the region was loaded
+	if (!region->get_path().is_empty() && region->get_path() != path) {
+		region->take_over_path(path);
+	}
+	if (region->save(path, p_16_bit, compression) == OK) {
+		String other_path = _get_region_path(p_dir, p_region_loc, !raw);
+		if (FileAccess::file_exists(other_path)) {
+			LOG(INFO, "Removing ", other_path, " replaced by ", path);
+			DirAccess::remove_absolute(ProjectSettings::get_singleton()->globalize_path(other_path));
+		}
+	}
 }
 
+/**
+ * Loads all region files in the directory in parallel.
+ * Every .res file is requested from ResourceLoader's thread pool at once, so decompression and image
+ * decoding run on all cores, while raw files are read on the WorkerThreadPool. Regions are then
+ * registered on the main thread as each finishes, and the maps are generated once at the end.
+ * If a location has files in both formats, the raw file is used.
+ * Maps not in Terrain3D.resident_maps are never decoded from raw files, and are freed after loading
+ * from .res files.
+ */
 void Terrain3DData::load_directory(const String &p_dir) {
+	if (_save.group_id >= 0) {
+		LOG(INFO, "Waiting for the previous save to finish");
+		_finish_save();
+	}
 	if (p_dir.is_empty()) {
 		LOG(ERROR, "Specified data directory is blank");
 		return;
@@ -242,40 +813,96 @@ void Terrain3DData::load_directory(const String &p_dir) {
 	_clear();
 
 	LOG(INFO, "Loading region files from ", p_dir);
+	ResourceLoader *rl = ResourceLoader::get_singleton();
+	PackedStringArray paths;
+	TypedArray<Vector2i> locations;
+	_load_items.clear();
 	PackedStringArray files = da->get_files();
 	for (int i = 0; i < files.size(); i++) {
 		String fname = files[i];
 		String path = p_dir + String("/") + fname;
-		if (!fname.begins_with("terrain3d") || !fname.ends_with(".res")) {
+		bool raw = fname.get_extension() == Terrain3DRegion::RAW_EXTENSION;
+		if (!fname.begins_with("terrain3d") || (!raw && fname.get_extension() != "res")) {
 			continue;
 		}
-		LOG(DEBUG, "Loading region from ", path);
 		Vector2i loc = Util::filename_to_location(fname);
 		if (loc.x == INT32_MAX) {
 			LOG(ERROR, "Cannot get region location from file name: ", fname);
 			continue;
 		}
-		Ref<Terrain3DRegion> region = ResourceLoader::get_singleton()->load(path, "Terrain3DRegion", ResourceLoader::CACHE_MODE_IGNORE);
+		if (raw) {
+			_load_items.push_back({ path, Ref<Terrain3DRegion>() });
+			continue;
+		}
+		if (files.has(fname.get_basename() + "." + Terrain3DRegion::RAW_EXTENSION)) {
+			LOG(WARN, "Region ", loc, " has both raw and .res files. Loading the raw file, skipping ", path);
+			continue;
+		}
+		LOG(DEBUG, "Requesting region from ", path);
+		Error err = rl->load_threaded_request(path, "Terrain3DRegion", false, ResourceLoader::CACHE_MODE_IGNORE);
+		if (err != OK) {
+			LOG(ERROR, "Cannot request region at ", path, ". Error code: ", err);
+			continue;
+		}
+		paths.push_back(path);
+		locations.push_back(loc);
+	}
+
+	// Raw files are read while the .res files load in the background
+	if (!_load_items.is_empty()) {
+		LOG(DEBUG, "Reading ", _load_items.size(), " raw region files");
+		Util::run_group_task(callable_mp(this, &Terrain3DData::_load_region_task), _load_items.size(), "Terrain3DData load");
+		for (const LoadItem &item : _load_items) {
+			if (item.region.is_null()) {
+				LOG(ERROR, "Cannot load region at ", item.path);
+				continue;
+			}
+			LOG(DEBUG, "Loaded region from ", item.path);
+			item.region->take_over_path(item.path);
+			item.region->set_location(Util::filename_to_location(item.path.get_file()));
+			item.region->set_version(CURRENT_VERSION); // Sends upgrade warning if old version
+			add_region(item.region, false);
+		}
+		_load_items.clear();
+	}
+
+	// Collect regions in request order. Each get blocks only on its own file, while the rest keep loading
+	for (int i = 0; i < paths.size(); i++) {
+		String path = paths[i];
+		// Returns null if the load failed
+		Ref<Terrain3DRegion> region = rl->load_threaded_get(path);
 		if (region.is_null()) {
 			LOG(ERROR, "Cannot load region at ", path);
 			continue;
 		}
+		LOG(DEBUG, "Loaded region from ", path);
 		region->take_over_path(path);
-		region->set_location(loc);
+		region->set_location(locations[i]);
 		region->set_version(CURRENT_VERSION); // Sends upgrade warning if old version
+		region->unload_maps(~_terrain->get_resident_maps());
 		add_region(region, false);
 	}
 	force_update_maps();
 }
 
 void Terrain3DData::load_region(const Vector2i &p_region_loc, const String &p_dir, const bool p_update) {
+	if (_save.group_id >= 0) {
+		LOG(INFO, "Waiting for the previous save to finish");
+		_finish_save();
+	}
 	LOG(INFO, "Loading region from location ", p_region_loc);
-	String path = p_dir + String("/") + Util::location_to_filename(p_region_loc);
-	if (!FileAccess::file_exists(path)) {
-		LOG(ERROR, "File ", path, " doesn't exist");
-		return;
+	Ref<Terrain3DRegion> region;
+	String path = _get_region_path(p_dir, p_region_loc, true);
+	if (FileAccess::file_exists(path)) {
+		region = Terrain3DRegion::load_raw(path, _terrain->get_resident_maps());
+	} else {
+		path = _get_region_path(p_dir, p_region_loc, false);
+		if (!FileAccess::file_exists(path)) {
+			LOG(ERROR, "File ", path, " doesn't exist");
+			return;
+		}
+		region = ResourceLoader::get_singleton()->load(path, "Terrain3DRegion", ResourceLoader::CACHE_MODE_IGNORE);
 	}
-	Ref<Terrain3DRegion> region = ResourceLoader::get_singleton()->load(path, "Terrain3DRegion", ResourceLoader::CACHE_MODE_IGNORE);
 	if (region.is_null()) {
 		LOG(ERROR, "Cannot load region at ", path);
 		return;
@@ -283,6 +910,7 @@ void Terrain3DData::load_region(const Vector2i &p_region_loc, const String &p_di
 	region->take_over_path(path);
 	region->set_location(p_region_loc);
 	region->set_version(CURRENT_VERSION); // Sends upgrade warning if old version
+	region->unload_maps(~_terrain->get_resident_maps());
 	add_region(region, p_update);
 }
 
@@ -307,6 +935,47 @@ TypedArray<Image> Terrain3DData::get_maps(const MapType p_map_type) const {
 	return TypedArray<Image>();
 }
 
+// Loads or frees maps of all regions to match Terrain3D.resident_maps. Regions with unsaved changes
+// keep their maps.
+void Terrain3DData::update_resident_maps() {
+	IS_DATA_INIT(VOID);
+	int mask = _terrain->get_resident_maps();
+	LOG(INFO, "Updating resident maps: ", mask);
+	Array locs = _regions.keys();
+	for (int i = 0; i < locs.size(); i++) {
+		Ref<Terrain3DRegion> region = _regions[locs[i]];
+		if (region.is_null()) {
+			continue;
+		}
+		region->load_maps(mask);
+		region->unload_maps(~mask);
+		_share_blank_maps(region);
+	}
+	force_update_maps();
+}
+
+// Height maps are kept as half floats at runtime if Terrain3D.runtime_16_bit is enabled. The editor
+// always uses 32-bit, as small brush strokes are lost to 16-bit precision. Converts loaded regions.
+void Terrain3DData::update_height_format() {
+	IS_DATA_INIT(VOID);
+	Image::Format format = (_terrain->get_runtime_16_bit() && !IS_EDITOR) ? Image::FORMAT_RH : Image::FORMAT_RF;
+	if (format == _height_format) {
+		return;
+	}
+	LOG(INFO, "Converting height maps to ", (format == Image::FORMAT_RH) ? "16" : "32", "-bit");
+	_height_format = format;
+	Array locs = _regions.keys();
+	for (int i = 0; i < locs.size(); i++) {
+		Ref<Terrain3DRegion> region = _regions[locs[i]];
+		if (region.is_valid() && region->get_height_map().is_valid()) {
+			region->get_height_map()->convert(format);
+		}
+	}
+	if (!_regions.is_empty()) {
+		force_update_maps(TYPE_HEIGHT);
+	}
+}
+
 void Terrain3DData::force_update_maps(const MapType p_map_type, const bool p_generate_mipmaps) {
 	LOG(DEBUG_CONT, "Regenerating maps of type: ", p_map_type);
 	switch (p_map_type) {
@@ -370,7 +1039,12 @@ void Terrain3DData::update_maps() {
 			Vector2i region_loc = _region_locations[i];
 			Ref<Terrain3DRegion> region = _regions[region_loc];
 			if (region.is_valid()) {
-				_height_maps.push_back(region->get_height_map());
+				// Maps set since update_height_format() may be in either format
+				Ref<Image> height_map = region->get_height_map();
+				if (height_map->get_format() != _height_format) {
+					height_map->convert(_height_format);
+				}
+				_height_maps.push_back(height_map);
 			} else {
 				LOG(ERROR, "Can't find region ", region_loc, ", _regions: ", _regions.size(),
 						", locations: ", _region_locations.size(), ". Please report this error.");
@@ -414,6 +1088,75 @@ void Terrain3DData::update_maps() {
 	}
 }
 
+// Uploads the maps of the specified regions to their existing layers in the TextureArray, rather
+// than regenerating the whole array. Falls back to force_update_maps() if the array must be rebuilt.
+void Terrain3DData::update_region_maps(const MapType p_map_type, const TypedArray<Vector2i> &p_region_locs) {
+	if (p_map_type < 0 || p_map_type > TYPE_MAX) {
+		LOG(ERROR, "Specified map type out of range");
+		return;
+	}
+	if (p_map_type == TYPE_MAX) {
+		for (int i = 0; i < TYPE_MAX; i++) {
+			update_region_maps(MapType(i), p_region_locs);
+		}
+		return;
+	}
+	GeneratedTexture *generated_maps = nullptr;
+	TypedArray<Image> *maps = nullptr;
+	switch (p_map_type) {
+		case TYPE_HEIGHT:
+			generated_maps = &_generated_height_maps;
+			maps = &_height_maps;
+			break;
+		case TYPE_CONTROL:
+			generated_maps = &_generated_control_maps;
+			maps = &_control_maps;
+			break;
+		default:
+			generated_maps = &_generated_color_maps;
+			maps = &_color_maps;
+			break;
+	}
+	if (_region_map_dirty || generated_maps->is_dirty() || (!generated_maps->get_rid().is_valid() && !IS_HEADLESS)) {
+		force_update_maps(p_map_type);
+		return;
+	}
+	// Verify all layers are current before uploading any of them
+	for (int i = 0; i < p_region_locs.size(); i++) {
+		int region_id = get_region_id(p_region_locs[i]);
+		if (region_id < 0) {
+			continue;
+		}
+		Ref<Terrain3DRegion> region = _regions[p_region_locs[i]];
+		Ref<Image> map = region.is_valid() ? region->get_map(p_map_type) : Ref<Image>();
+		if (region_id >= maps->size() || map != Ref<Image>((*maps)[region_id])) {
+			LOG(DEBUG_CONT, "Region ", p_region_locs[i], " map has been replaced, regenerating all");
+			force_update_maps(p_map_type);
+			return;
+		}
+	}
+	LOG(DEBUG_CONT, "Updating ", p_region_locs.size(), " layers of type: ", p_map_type);
+	for (int i = 0; i < p_region_locs.size(); i++) {
+		int region_id = get_region_id(p_region_locs[i]);
+		if (region_id >= 0) {
+			Ref<Image> map = (*maps)[region_id];
+			generated_maps->update(map, region_id);
+		}
+	}
+	switch (p_map_type) {
+		case TYPE_HEIGHT:
+			calc_height_range();
+			emit_signal("height_maps_changed");
+			break;
+		case TYPE_CONTROL:
+			emit_signal("control_maps_changed");
+			break;
+		default:
+			emit_signal("color_maps_changed");
+			break;
+	}
+}
+
 void Terrain3DData::set_pixel(const MapType p_map_type, const Vector3 &p_global_position, const Color &p_pixel) {
 	if (p_map_type < 0 || p_map_type >= TYPE_MAX) {
 		LOG(ERROR, "Specified map type out of range");
@@ -425,13 +1168,14 @@ void Terrain3DData::set_pixel(const MapType p_map_type, const Vector3 &p_global_
 		LOG(ERROR, "No region found at: ", p_global_position);
 		return;
 	}
+	region->load_maps(1 << p_map_type);
 	Vector2i global_offset = region_loc * _region_size;
 	Vector3 descaled_pos = p_global_position / _mesh_vertex_spacing;
 	Vector2i img_pos = Vector2i(descaled_pos.x - global_offset.x, descaled_pos.z - global_offset.y);
 	img_pos = img_pos.clamp(V2I_ZERO, Vector2i(_region_size - 1, _region_size - 1));
 	Ref<Image> map = region->get_map(p_map_type);
 	map->set_pixelv(img_pos, p_pixel);
-	region->set_modified(true);
+	region->mark_dirty(p_map_type, Rect2i(img_pos, Vector2i(1, 1)));
 }
 
 Color Terrain3DData::get_pixel(const MapType p_map_type, const Vector3 &p_global_position) const {
@@ -631,6 +1375,180 @@ void Terrain3DData::calc_height_range(const bool p_recursive) {
 	LOG(DEBUG_CONT, "Accumulated height range for all regions: ", _master_height_range);
 }
 
+/**
+ * Erodes the heights within an area, which may span regions. Each iteration runs particle based
+ * hydraulic erosion followed by thermal erosion, which moves material down slopes steeper than
+ * the talus angle. Work is spread across the WorkerThreadPool, and results are identical for the
+ * same seed and parameters. See the documentation for p_params.
+ */
+void Terrain3DData::erode(const AABB &p_area, const Dictionary &p_params) {
+	IS_INIT_MESG("Data not initialized", VOID);
+	Rect2i rect = _get_pixel_rect(p_area);
+	if (!rect.has_area()) {
+		LOG(ERROR, "Erosion area ", p_area, " is empty or outside of the world");
+		return;
+	}
+
+	int iterations = CLAMP(int(p_params.get("iterations", 1)), 1, 1000);
+	bool hydraulic = p_params.get("hydraulic", true);
+	bool thermal = p_params.get("thermal", true);
+	_erosion.seed = uint32_t(int64_t(p_params.get("seed", 0)));
+	_erosion.droplet_density = CLAMP(real_t(p_params.get("droplet_density", .05f)), 0.f, 10.f);
+	_erosion.lifetime = CLAMP(int(p_params.get("droplet_lifetime", 30)), 1, EROSION_MAX_LIFETIME);
+	_erosion.inertia = CLAMP(real_t(p_params.get("inertia", .05f)), 0.f, 1.f);
+	_erosion.capacity = CLAMP(real_t(p_params.get("sediment_capacity", 4.f)), 0.f, 100.f);
+	_erosion.min_capacity = CLAMP(real_t(p_params.get("min_sediment_capacity", .01f)), 0.f, 100.f);
+	_erosion.erode_speed = CLAMP(real_t(p_params.get("erode_speed", .3f)), 0.f, 1.f);
+	_erosion.deposit_speed = CLAMP(real_t(p_params.get("deposit_speed", .3f)), 0.f, 1.f);
+	_erosion.evaporate_speed = CLAMP(real_t(p_params.get("evaporate_speed", .01f)), 0.f, 1.f);
+	_erosion.gravity = CLAMP(real_t(p_params.get("gravity", 4.f)), 0.f, 100.f);
+	real_t talus_angle = CLAMP(real_t(p_params.get("talus_angle", 35.f)), 0.f, 89.f);
+	_erosion.talus = Math::tan(Math::deg_to_rad(talus_angle)) * _mesh_vertex_spacing;
+	_erosion.thermal_strength = CLAMP(real_t(p_params.get("thermal_strength", .5f)), 0.f, 1.f);
+	LOG(INFO, "Eroding ", rect, " pixels, iterations: ", iterations, ", hydraulic: ", hydraulic, ", thermal: ", thermal);
+
+	// Read heights left out by Terrain3D.resident_maps, so real heights are eroded, not placeholders
+	Vector2i loc_min = Vector2i((Vector2(rect.position) / real_t(_region_size)).floor());
+	Vector2i loc_max = Vector2i((Vector2(rect.get_end() - Vector2i(1, 1)) / real_t(_region_size)).floor());
+	for (int ly = loc_min.y; ly <= loc_max.y; ly++) {
+		for (int lx = loc_min.x; lx <= loc_max.x; lx++) {
+			Vector2i region_loc = Vector2i(lx, ly);
+			if (has_region(region_loc)) {
+				Ref<Terrain3DRegion> region = _regions[region_loc];
+				region->load_maps(1 << TYPE_HEIGHT);
+			}
+		}
+	}
+
+	_erosion.rect = rect;
+	_erosion.tiles = Vector2i((rect.size + Vector2i(EROSION_TILE_SIZE - 1, EROSION_TILE_SIZE - 1)) / EROSION_TILE_SIZE);
+	_erosion.buffers[0].resize(rect.size.x * rect.size.y);
+	_erosion.heights = _erosion.buffers[0].ptr();
+	_copy_heights(rect, _erosion.heights);
+	if (thermal) {
+		_erosion.buffers[1].resize(rect.size.x * rect.size.y);
+		_erosion.scratch = _erosion.buffers[1].ptr();
+	}
+
+	for (int i = 0; i < iterations; i++) {
+		_erosion.iteration = i;
+		if (hydraulic) {
+			// Process alternating tiles in four phases so tiles running together never share pixels
+			for (int phase = 0; phase < 4; phase++) {
+				_erosion.phase_tiles.clear();
+				for (int y = phase / 2; y < _erosion.tiles.y; y += 2) {
+					for (int x = phase % 2; x < _erosion.tiles.x; x += 2) {
+						_erosion.phase_tiles.push_back(Vector2i(x, y));
+					}
+				}
+				Util::run_group_task(callable_mp(this, &Terrain3DData::_erode_hydraulic_tile),
+						_erosion.phase_tiles.size(), "Terrain3D hydraulic erosion");
+			}
+		}
+		if (thermal) {
+			Util::run_group_task(callable_mp(this, &Terrain3DData::_erode_thermal_row),
+					rect.size.y, "Terrain3D thermal erosion");
+			SWAP(_erosion.heights, _erosion.scratch);
+		}
+	}
+
+	TypedArray<Vector2i> region_locs = _paste_heights(rect, _erosion.heights);
+	_erosion = ErosionJob();
+	update_region_maps(TYPE_HEIGHT, region_locs);
+
+	add_edited_area(_get_pixel_area(rect));
+}
+
+/**
+ * Fills the heights within an area with fractal noise, adding regions where needed. Tiles are
+ * generated on the WorkerThreadPool, and results are identical for the same seed and parameters.
+ * See the documentation for p_params.
+ */
+void Terrain3DData::generate_heights(const AABB &p_area, const Dictionary &p_params) {
+	IS_INIT_MESG("Data not initialized", VOID);
+	Rect2i rect = _get_pixel_rect(p_area);
+	if (!rect.has_area()) {
+		LOG(ERROR, "Generation area ", p_area, " is empty or outside of the world");
+		return;
+	}
+
+	_generate.seed = uint32_t(int64_t(p_params.get("seed", 0)));
+	_generate.octaves = CLAMP(int(p_params.get("octaves", 6)), 1, 16);
+	_generate.frequency = CLAMP(real_t(p_params.get("frequency", .002f)), 0.f, 10.f);
+	_generate.lacunarity = CLAMP(real_t(p_params.get("lacunarity", 2.f)), 1.f, 4.f);
+	_generate.gain = CLAMP(real_t(p_params.get("gain", .5f)), 0.f, 1.f);
+	_generate.ridged = p_params.get("ridged", false);
+	_generate.warp_strength = CLAMP(real_t(p_params.get("warp_strength", 0.f)), 0.f, 100.f);
+	_generate.warp_frequency = CLAMP(real_t(p_params.get("warp_frequency", .5f)), 0.f, 100.f);
+	_generate.height = p_params.get("height", 200.f);
+	_generate.offset = p_params.get("offset", 0.f);
+	_generate.additive = p_params.get("additive", false);
+	LOG(INFO, "Generating heights in ", rect, " pixels, seed: ", _generate.seed, ", octaves: ", _generate.octaves,
+			", ridged: ", _generate.ridged, ", warp: ", _generate.warp_strength);
+
+	// Add missing regions without updating, then split the area into tiles within regions
+	bool regions_added = false;
+	TypedArray<Vector2i> region_locs;
+	Vector2i loc_min = Vector2i((Vector2(rect.position) / real_t(_region_size)).floor());
+	Vector2i loc_max = Vector2i((Vector2(rect.get_end() - Vector2i(1, 1)) / real_t(_region_size)).floor());
+	for (int ly = loc_min.y; ly <= loc_max.y; ly++) {
+		for (int lx = loc_min.x; lx <= loc_max.x; lx++) {
+			Vector2i region_loc = Vector2i(lx, ly);
+			Ref<Terrain3DRegion> region;
+			if (has_region(region_loc)) {
+				region = _regions[region_loc];
+			} else {
+				region = add_region_blank(region_loc, false);
+				regions_added = true;
+			}
+			if (region.is_null()) {
+				continue;
+			}
+			region->load_maps(1 << TYPE_HEIGHT);
+			region_locs.push_back(region_loc);
+			Vector2i region_offset = region_loc * _region_size;
+			Rect2i area = rect.intersection(Rect2i(region_offset, _region_sizev));
+			Ref<Image> height_map = region->get_height_map();
+			uint8_t *map = height_map->ptrw();
+			const bool half = is_half_height(height_map);
+			Vector2i start = area.position - region_offset;
+			Vector2i end = area.get_end() - region_offset;
+			for (int y = start.y; y < end.y; y = (y / GENERATE_TILE_SIZE + 1) * GENERATE_TILE_SIZE) {
+				for (int x = start.x; x < end.x; x = (x / GENERATE_TILE_SIZE + 1) * GENERATE_TILE_SIZE) {
+					Vector2i tile_end = Vector2i(MIN((x / GENERATE_TILE_SIZE + 1) * GENERATE_TILE_SIZE, end.x),
+							MIN((y / GENERATE_TILE_SIZE + 1) * GENERATE_TILE_SIZE, end.y));
+					GenerateTile tile;
+					tile.rect = Rect2i(region_offset + Vector2i(x, y), tile_end - Vector2i(x, y));
+					tile.map = map;
+					tile.half = half;
+					tile.region_loc = region_loc;
+					_generate.tiles.push_back(tile);
+				}
+			}
+		}
+	}
+
+	Util::run_group_task(callable_mp(this, &Terrain3DData::_generate_tile), _generate.tiles.size(), "Terrain3D generate heights");
+
+	// Merge the tile height ranges into their regions
+	for (const GenerateTile &tile : _generate.tiles) {
+		Ref<Terrain3DRegion> region = _regions[tile.region_loc];
+		region->update_heights(tile.height_range);
+		update_master_heights(tile.height_range);
+		region->mark_dirty(TYPE_HEIGHT, Rect2i(tile.rect.position - tile.region_loc * _region_size, tile.rect.size));
+	}
+	_generate = GenerateJob();
+
+	// New regions need every map rebuilt, otherwise only the affected height layers are updated
+	if (regions_added) {
+		force_update_maps();
+	} else {
+		update_region_maps(TYPE_HEIGHT, region_locs);
+	}
+
+	add_edited_area(_get_pixel_area(rect));
+}
+
 /**
  * Imports an Image set (Height, Control, Color) into Terrain3DData
  * It does NOT normalize values to 0-1. You must do that using get_min_max() and adjusting scale and offset.
@@ -668,90 +1586,113 @@ void Terrain3DData::import_images(const TypedArray<Image> &p_images, const Vecto
 		return;
 	}
 
-	Vector3 descaled_position = p_global_position / _mesh_vertex_spacing;
-	int max_dimension = _region_size * REGION_MAP_SIZE / 2;
-	if ((abs(descaled_position.x) > max_dimension) || (abs(descaled_position.z) > max_dimension)) {
-		LOG(ERROR, "Specify a position within +/-", Vector3(max_dimension, 0.f, max_dimension) * _mesh_vertex_spacing);
+	if (!_check_import_size(img_size, p_global_position)) {
 		return;
 	}
-	if ((descaled_position.x + img_size.x > max_dimension) ||
-			(descaled_position.z + img_size.y > max_dimension)) {
-		LOG(ERROR, img_size, " image will not fit at ", p_global_position,
-				". Try ", -(img_size * _mesh_vertex_spacing) / 2.f, " to center");
-		return;
-	}
-
-	TypedArray<Image> tmp_images;
-	tmp_images.resize(TYPE_MAX);
 
-	for (int i = 0; i < TYPE_MAX; i++) {
-		Ref<Image> img = p_images[i];
-		tmp_images[i] = img;
-		if (img.is_null()) {
-			continue;
-		}
-
-		// Apply scale and offsets to a new heightmap if applicable
-		if (i == TYPE_HEIGHT && (p_offset != 0.f || p_scale != 1.f)) {
-			LOG(DEBUG, "Creating new temp image to adjust scale: ", p_scale, " offset: ", p_offset);
-			Ref<Image> newimg = Image::create(img->get_size().x, img->get_size().y, false, FORMAT[TYPE_HEIGHT]);
-			for (int y = 0; y < img->get_height(); y++) {
-				for (int x = 0; x < img->get_width(); x++) {
-					Color clr = img->get_pixel(x, y);
-					clr.r = (clr.r * p_scale) + p_offset;
-					newimg->set_pixel(x, y, clr);
-				}
-			}
-			tmp_images[i] = newimg;
-		}
-	}
-
-	// Slice up incoming image into segments of region_size^2, and pad any remainder
+	// Slice up incoming images into segments of region_size^2, and pad any remainder
 	int slices_width = ceil(real_t(img_size.x) / real_t(_region_size));
 	int slices_height = ceil(real_t(img_size.y) / real_t(_region_size));
 	slices_width = CLAMP(slices_width, 1, REGION_MAP_SIZE);
 	slices_height = CLAMP(slices_height, 1, REGION_MAP_SIZE);
 	LOG(DEBUG, "Creating ", Vector2i(slices_width, slices_height), " slices for ", img_size, " images.");
 
+	for (int i = 0; i < TYPE_MAX; i++) {
+		_import.images[i] = p_images[i];
+	}
+	_import.position = p_global_position / _mesh_vertex_spacing;
+	_import.offset = p_offset;
+	_import.scale = p_scale;
 	for (int y = 0; y < slices_height; y++) {
 		for (int x = 0; x < slices_width; x++) {
-			Vector2i start_coords = Vector2i(x * _region_size, y * _region_size);
-			Vector2i end_coords = Vector2i((x + 1) * _region_size, (y + 1) * _region_size);
-			LOG(DEBUG, "Reviewing image section ", start_coords, " to ", end_coords);
+			ImportSlice slice;
+			slice.start = Vector2i(x, y) * _region_size;
+			slice.size = Vector2i(MIN(_region_size, img_size.x - slice.start.x), MIN(_region_size, img_size.y - slice.start.y));
+			_import.slices.push_back(slice);
+		}
+	}
+	Util::run_group_task(callable_mp(this, &Terrain3DData::_import_slice), _import.slices.size(), "Terrain3D import images");
 
-			Vector2i size_to_copy;
-			if (end_coords.x <= img_size.x && end_coords.y <= img_size.y) {
-				size_to_copy = _region_sizev;
-			} else {
-				size_to_copy.x = img_size.x - start_coords.x;
-				size_to_copy.y = img_size.y - start_coords.y;
-				LOG(DEBUG, "Uneven end piece. Copying padded slice ", Vector2i(x, y), " size to copy: ", size_to_copy);
-			}
-
-			LOG(DEBUG, "Copying ", size_to_copy, " sized segment");
-			TypedArray<Image> images;
-			images.resize(TYPE_MAX);
-			for (int i = 0; i < TYPE_MAX; i++) {
-				Ref<Image> img = tmp_images[i];
-				Ref<Image> img_slice;
-				if (img.is_valid() && !img->is_empty()) {
-					img_slice = Util::get_filled_image(_region_sizev, COLOR[i], false, img->get_format());
-					img_slice->blit_rect(tmp_images[i], Rect2i(start_coords, size_to_copy), V2I_ZERO);
-				} else {
-					img_slice = Util::get_filled_image(_region_sizev, COLOR[i], false, FORMAT[i]);
-				}
-				images[i] = img_slice;
-			}
-			// Add the heightmap slice and only regenerate on the last one
-			Ref<Terrain3DRegion> region;
-			region.instantiate();
-			Vector3 position = Vector3(descaled_position.x + start_coords.x, 0.f, descaled_position.z + start_coords.y);
-			position *= _mesh_vertex_spacing;
-			region->set_location(get_region_location(position));
-			region->set_maps(images);
-			add_region(region, (x == slices_width - 1 && y == slices_height - 1));
+	// Add the regions and only regenerate on the last one
+	for (uint32_t i = 0; i < _import.slices.size(); i++) {
+		add_region(_import.slices[i].region, i == _import.slices.size() - 1);
+	}
+	_import = ImportJob();
+}
+
+/**
+ * Imports a height map file, as import_images() does with a height map Image. R16/raw files are
+ * read in strips one region tall, so the whole file is never in memory, and the regions of each
+ * strip are built on the WorkerThreadPool. Other formats can't be read in parts, so they are
+ * loaded whole with Terrain3DUtil::load_image().
+ *	p_r16_height_range - R16 format: x=Min & y=Max heights, mapped from 0 and 65535
+ *	p_r16_size - R16 format: Image dimensions. Default (0,0) auto detects f/ square images
+ */
+Error Terrain3DData::import_height_file(const String &p_file_name, const Vector3 &p_global_position, const real_t p_offset,
+		const real_t p_scale, const Vector2 &p_r16_height_range, const Vector2i &p_r16_size) {
+	IS_INIT_MESG("Data not initialized", ERR_UNCONFIGURED);
+	String ext = p_file_name.get_extension().to_lower();
+	if (ext != "r16" && ext != "raw") {
+		Ref<Image> img = Util::load_image(p_file_name);
+		if (img.is_null()) {
+			return ERR_FILE_CANT_READ;
+		}
+		TypedArray<Image> images;
+		images.resize(TYPE_MAX);
+		images[TYPE_HEIGHT] = img;
+		import_images(images, p_global_position, p_offset, p_scale);
+		return OK;
+	}
+
+	Ref<FileAccess> file = FileAccess::open(p_file_name, FileAccess::READ);
+	if (file.is_null()) {
+		LOG(ERROR, "Cannot open file: ", p_file_name, ". Error code: ", FileAccess::get_open_error());
+		return FileAccess::get_open_error();
+	}
+	// If p_r16_size is zero, assume square and detect the size
+	Vector2i img_size = p_r16_size;
+	if (img_size <= V2I_ZERO) {
+		int width = sqrt(file->get_length() / 2);
+		img_size = Vector2i(width, width);
+	}
+	if (img_size.x <= 0 || img_size.y <= 0 || file->get_length() < int64_t(img_size.x) * img_size.y * 2) {
+		LOG(ERROR, "File ", p_file_name, " is smaller than ", img_size, " 16-bit pixels");
+		return ERR_FILE_CORRUPT;
+	}
+	if (!_check_import_size(img_size, p_global_position)) {
+		return ERR_PARAMETER_RANGE_ERROR;
+	}
+	LOG(INFO, "Importing ", p_file_name, ", size: ", img_size, ", height range: ", p_r16_height_range,
+			", offset: ", p_offset, ", scale: ", p_scale);
+
+	// Fold the 16-bit to height range conversion into the scale and offset
+	real_t r16_scale = (p_r16_height_range.y - p_r16_height_range.x) / 65535.0f;
+	_import.position = p_global_position / _mesh_vertex_spacing;
+	_import.offset = p_r16_height_range.x * p_scale + p_offset;
+	_import.scale = r16_scale * p_scale;
+	_import.strip_width = img_size.x;
+	int slices_width = CLAMP(int(ceil(real_t(img_size.x) / real_t(_region_size))), 1, REGION_MAP_SIZE);
+	int slices_height = CLAMP(int(ceil(real_t(img_size.y) / real_t(_region_size))), 1, REGION_MAP_SIZE);
+	for (int y = 0; y < slices_height; y++) {
+		int rows = MIN(_region_size, img_size.y - y * _region_size);
+		PackedByteArray strip = file->get_buffer(int64_t(rows) * img_size.x * 2);
+		LOG(DEBUG, "Read strip ", y, " of ", slices_height, ", ", rows, " rows");
+		_import.strip = strip.ptr();
+		_import.slices.clear();
+		for (int x = 0; x < slices_width; x++) {
+			ImportSlice slice;
+			slice.start = Vector2i(x * _region_size, y * _region_size);
+			slice.size = Vector2i(MIN(_region_size, img_size.x - slice.start.x), rows);
+			_import.slices.push_back(slice);
 		}
-	} // for y < slices_height, x < slices_width
+		Util::run_group_task(callable_mp(this, &Terrain3DData::_import_slice), _import.slices.size(), "Terrain3D import heights");
+		for (const ImportSlice &slice : _import.slices) {
+			add_region(slice.region, false);
+		}
+	}
+	_import = ImportJob();
+	force_update_maps();
+	return OK;
 }
 
 /** Exports a specified map as one of r16/raw, exr, jpg, png, webp, res, tres
@@ -945,7 +1886,8 @@ void Terrain3DData::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("remove_regionl", "region_location", "update"), &Terrain3DData::remove_regionl, DEFVAL(true));
 	ClassDB::bind_method(D_METHOD("remove_region", "region", "update"), &Terrain3DData::remove_region, DEFVAL(true));
 
-	ClassDB::bind_method(D_METHOD("save_directory", "directory"), &Terrain3DData::save_directory);
+	ClassDB::bind_method(D_METHOD("save_directory", "directory", "async"), &Terrain3DData::save_directory, DEFVAL(false));
+	ClassDB::bind_method(D_METHOD("is_saving"), &Terrain3DData::is_saving);
 	ClassDB::bind_method(D_METHOD("save_region", "directory", "region_location", "16_bit"), &Terrain3DData::save_region, DEFVAL(false));
 	ClassDB::bind_method(D_METHOD("load_directory", "directory"), &Terrain3DData::load_directory);
 	ClassDB::bind_method(D_METHOD("load_region", "directory", "region_location", "update"), &Terrain3DData::load_region, DEFVAL(true));
@@ -955,6 +1897,7 @@ void Terrain3DData::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("get_color_maps"), &Terrain3DData::get_color_maps);
 	ClassDB::bind_method(D_METHOD("get_maps", "map_type"), &Terrain3DData::get_maps);
 	ClassDB::bind_method(D_METHOD("force_update_maps", "map_type", "generate_mipmaps"), &Terrain3DData::force_update_maps, DEFVAL(TYPE_MAX), DEFVAL(false));
+	ClassDB::bind_method(D_METHOD("update_region_maps", "map_type", "region_locations"), &Terrain3DData::update_region_maps);
 	ClassDB::bind_method(D_METHOD("get_height_maps_rid"), &Terrain3DData::get_height_maps_rid);
 	ClassDB::bind_method(D_METHOD("get_control_maps_rid"), &Terrain3DData::get_control_maps_rid);
 	ClassDB::bind_method(D_METHOD("get_color_maps_rid"), &Terrain3DData::get_color_maps_rid);
@@ -979,7 +1922,10 @@ void Terrain3DData::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("get_height_range"), &Terrain3DData::get_height_range);
 	ClassDB::bind_method(D_METHOD("calc_height_range", "recursive"), &Terrain3DData::calc_height_range, DEFVAL(false));
 
+	ClassDB::bind_method(D_METHOD("erode", "area", "params"), &Terrain3DData::erode, DEFVAL(Dictionary()));
+	ClassDB::bind_method(D_METHOD("generate_heights", "area", "params"), &Terrain3DData::generate_heights, DEFVAL(Dictionary()));
 	ClassDB::bind_method(D_METHOD("import_images", "images", "global_position", "offset", "scale"), &Terrain3DData::import_images, DEFVAL(Vector3(0, 0, 0)), DEFVAL(0.0), DEFVAL(1.0));
+	ClassDB::bind_method(D_METHOD("import_height_file", "file_name", "global_position", "offset", "scale", "r16_height_range", "r16_size"), &Terrain3DData::import_height_file, DEFVAL(Vector3(0, 0, 0)), DEFVAL(0.0), DEFVAL(1.0), DEFVAL(Vector2(0, 255)), DEFVAL(V2I_ZERO));
 	ClassDB::bind_method(D_METHOD("export_image", "file_name", "map_type"), &Terrain3DData::export_image);
 	ClassDB::bind_method(D_METHOD("layered_to_image", "map_type"), &Terrain3DData::layered_to_image);
 
@@ -995,4 +1941,6 @@ void Terrain3DData::_bind_methods() {
 	ADD_SIGNAL(MethodInfo("control_maps_changed"));
 	ADD_SIGNAL(MethodInfo("color_maps_changed"));
 	ADD_SIGNAL(MethodInfo("maps_edited", PropertyInfo(Variant::AABB, "edited_area")));
+	ADD_SIGNAL(MethodInfo("save_progress", PropertyInfo(Variant::INT, "completed"), PropertyInfo(Variant::INT, "total")));
+	ADD_SIGNAL(MethodInfo("save_finished", PropertyInfo(Variant::INT, "errors")));
 }
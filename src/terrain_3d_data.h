@@ -3,6 +3,9 @@
 #ifndef TERRAIN3D_DATA_CLASS_H
 #define TERRAIN3D_DATA_CLASS_H
 
+#include <godot_cpp/templates/local_vector.hpp>
+#include <godot_cpp/templates/safe_refcount.hpp>
+
 #include "constants.h"
 #include "generated_texture.h"
 #include "terrain_3d_region.h"
@@ -17,7 +20,7 @@ class Terrain3DData : public Object {
 	friend Terrain3D;
 
 public: // Constants
-	static inline const real_t CURRENT_VERSION = 0.93f;
+	static inline const real_t CURRENT_VERSION = 0.94f;
 	static inline const int REGION_MAP_SIZE = 16;
 	static inline const Vector2i REGION_MAP_VSIZE = Vector2i(REGION_MAP_SIZE, REGION_MAP_SIZE);
 
@@ -26,6 +29,13 @@ public: // Constants
 		HEIGHT_FILTER_MINIMUM
 	};
 
+	// Hydraulic erosion runs on tiles of this size, in pixels. Droplets may leave their tile by up
+	// to their lifetime, so the lifetime is limited to half of the tile size.
+	static inline const int EROSION_TILE_SIZE = 128;
+	static inline const int EROSION_MAX_LIFETIME = EROSION_TILE_SIZE / 2 - 2;
+	// generate_heights() runs on tiles of this size, in pixels. Region sizes are multiples of it.
+	static inline const int GENERATE_TILE_SIZE = 64;
+
 private:
 	Terrain3D *_terrain = nullptr;
 
@@ -33,6 +43,7 @@ private:
 	int _region_size = 0; // Set by Terrain3D::set_region_size
 	Vector2i _region_sizev = Vector2i(_region_size, _region_size);
 	real_t _mesh_vertex_spacing = 1.f; // Set by Terrain3D::set_mesh_vertex_spacing
+	Image::Format _height_format = Image::FORMAT_RF; // Set by Terrain3D::set_runtime_16_bit
 
 	AABB _edited_area;
 	Vector2 _master_height_range = V2_ZERO;
@@ -75,13 +86,127 @@ private:
 	GeneratedTexture _generated_control_maps;
 	GeneratedTexture _generated_color_maps;
 
+	// One copy of the pixels of blank maps, shared by all regions, see _share_blank_maps()
+	Ref<Image> _blank_maps[TYPE_MAX];
+
+	// Settings and buffers for erode(), shared with the worker threads
+	struct ErosionJob {
+		Rect2i rect; // In global pixel coordinates
+		LocalVector<float> buffers[2];
+		float *heights = nullptr; // Current buffer, NAN where there is no region
+		float *scratch = nullptr; // Output for thermal erosion
+		Vector2i tiles;
+		LocalVector<Vector2i> phase_tiles; // Hydraulic tiles processed in the current phase
+		uint32_t seed = 0;
+		uint32_t iteration = 0;
+		real_t droplet_density = 0.f;
+		int lifetime = 0;
+		real_t inertia = 0.f;
+		real_t capacity = 0.f;
+		real_t min_capacity = 0.f;
+		real_t erode_speed = 0.f;
+		real_t deposit_speed = 0.f;
+		real_t evaporate_speed = 0.f;
+		real_t gravity = 0.f;
+		real_t talus = 0.f; // Height difference between adjacent pixels
+		real_t thermal_strength = 0.f;
+	};
+	ErosionJob _erosion;
+
+	// Settings and tiles for generate_heights(), shared with the worker threads
+	struct GenerateTile {
+		Rect2i rect; // In global pixel coordinates, within one region
+		uint8_t *map = nullptr; // Height map of the region
+		bool half = false; // See is_half_height()
+		Vector2i region_loc;
+		Vector2 height_range = Vector2(FLT_MAX, -FLT_MAX);
+	};
+	struct GenerateJob {
+		LocalVector<GenerateTile> tiles;
+		uint32_t seed = 0;
+		int octaves = 0;
+		real_t frequency = 0.f;
+		real_t lacunarity = 0.f;
+		real_t gain = 0.f;
+		bool ridged = false;
+		real_t warp_strength = 0.f;
+		real_t warp_frequency = 0.f;
+		real_t height = 0.f;
+		real_t offset = 0.f;
+		bool additive = false;
+	};
+	GenerateJob _generate;
+
+	// Regions built by import_images() and import_height_file() on the WorkerThreadPool, one per
+	// region sized slice of the source. Heights come from the source Image, or a strip of r16 rows.
+	struct ImportSlice {
+		Vector2i start; // In source pixels
+		Vector2i size; // Pixels copied from the source, the remainder of the region is padded
+		Ref<Terrain3DRegion> region;
+	};
+	struct ImportJob {
+		LocalVector<ImportSlice> slices;
+		Ref<Image> images[TYPE_MAX];
+		const uint8_t *strip = nullptr; // r16 rows of the current slices, starting at their first row
+		int strip_width = 0;
+		Vector3 position; // Descaled global position of the source
+		real_t offset = 0.f; // Applied to heights. For r16, they also map 16-bit values to the height range
+		real_t scale = 1.f;
+	};
+	ImportJob _import;
+
+	// Modified regions written by save_directory() on the WorkerThreadPool. Each snapshot is saved to
+	// a hidden temporary file beside its region file, then renamed over it once all have finished.
+	struct SaveItem {
+		Ref<Terrain3DRegion> region;
+		Ref<Terrain3DRegion> snapshot; // See Terrain3DRegion::get_save_snapshot()
+		String path;
+		String abs_path;
+		String temp_path; // Absolute, so the editor doesn't track it
+		bool in_place = false; // Raw file updated w/ only the changed chunks, see Terrain3DRegion::update_raw()
+		Error error = OK;
+	};
+	struct SaveJob {
+		LocalVector<SaveItem> items;
+		bool save_16_bit = false;
+		bool save_raw = false; // See Terrain3DRegion::save_raw()
+		int raw_compression = Terrain3DRegion::RAW_UNCOMPRESSED;
+		int64_t group_id = -1; // Running async if >= 0
+		SafeNumeric<uint32_t> completed;
+		uint32_t reported = 0; // Completed count last emitted by save_progress
+	};
+	SaveJob _save;
+
+	// Raw region files read by load_directory() on the WorkerThreadPool
+	struct LoadItem {
+		String path;
+		Ref<Terrain3DRegion> region;
+	};
+	LocalVector<LoadItem> _load_items;
+
 	// Functions
 	void _clear();
+	void _share_blank_maps(const Ref<Terrain3DRegion> &p_region);
+	Rect2i _get_pixel_rect(const AABB &p_area) const;
+	AABB _get_pixel_area(const Rect2i &p_rect) const;
+	void _copy_heights(const Rect2i &p_rect, float *p_heights) const;
+	TypedArray<Vector2i> _paste_heights(const Rect2i &p_rect, const float *p_heights);
+	void _erode_hydraulic_tile(const uint32_t p_index);
+	void _erode_thermal_row(const uint32_t p_row);
+	real_t _get_fractal_noise(const Vector2 &p_pos, const uint32_t p_seed, const int p_octaves) const;
+	void _generate_tile(const uint32_t p_index);
+	bool _check_import_size(const Vector2i &p_size, const Vector3 &p_global_position) const;
+	void _import_slice(const uint32_t p_index);
+	void _save_region_task(const uint32_t p_index);
+	void _load_region_task(const uint32_t p_index);
+	String _get_region_path(const String &p_dir, const Vector2i &p_region_loc, const bool p_raw) const;
+	void _update_save();
+	void _finish_save();
 
 public:
 	Terrain3DData() {}
 	void initialize(Terrain3D *p_terrain);
-	~Terrain3DData() { _clear(); }
+	~Terrain3DData();
 
 	// Regions
 
@@ -115,7 +240,8 @@ public:
 	void remove_region(const Ref<Terrain3DRegion> &p_region, const bool p_update = true);
 
 	// File I/O
-	void save_directory(const String &p_dir);
+	void save_directory(const String &p_dir, const bool p_async = false);
+	bool is_saving() const { return _save.group_id >= 0; }
 	void save_region(const Vector2i &p_region_loc, const String &p_dir, const bool p_16_bit = false);
 	void load_directory(const String &p_dir);
 	void load_region(const Vector2i &p_region_loc, const String &p_dir, const bool p_update = true);
@@ -125,8 +251,12 @@ public:
 	TypedArray<Image> get_control_maps() const { return _control_maps; }
 	TypedArray<Image> get_color_maps() const { return _color_maps; }
 	TypedArray<Image> get_maps(const MapType p_map_type) const;
+	void update_resident_maps();
+	void update_height_format();
+	Image::Format get_height_format() const { return _height_format; }
 	void force_update_maps(const MapType p_map = TYPE_MAX, const bool p_generate_mipmaps = false);
 	void update_maps();
+	void update_region_maps(const MapType p_map_type, const TypedArray<Vector2i> &p_region_locs);
 	RID get_height_maps_rid() const { return _generated_height_maps.get_rid(); }
 	RID get_control_maps_rid() const { return _generated_control_maps.get_rid(); }
 	RID get_color_maps_rid() const { return _generated_color_maps.get_rid(); }
@@ -157,8 +287,14 @@ public:
 	void update_master_heights(const Vector2 &p_low_high);
 	void calc_height_range(const bool p_recursive = false);
 
+	void erode(const AABB &p_area, const Dictionary &p_params = Dictionary());
+	void generate_heights(const AABB &p_area, const Dictionary &p_params = Dictionary());
+
 	void import_images(const TypedArray<Image> &p_images, const Vector3 &p_global_position = V3_ZERO,
 			const real_t p_offset = 0.f, const real_t p_scale = 1.f);
+	Error import_height_file(const String &p_file_name, const Vector3 &p_global_position = V3_ZERO,
+			const real_t p_offset = 0.f, const real_t p_scale = 1.f,
+			const Vector2 &p_r16_height_range = Vector2(0.f, 255.f), const Vector2i &p_r16_size = V2I_ZERO);
 	Error export_image(const String &p_file_name, const MapType p_map_type = TYPE_HEIGHT) const;
 	Ref<Image> layered_to_image(const MapType p_map_type) const;
 
@@ -95,7 +95,6 @@ void Terrain3DEditor::_operate_map(const Vector3 &p_global_position, const real_
 	}
 
 	int region_size = _terrain->get_region_size();
-	Vector2i region_vsize = Vector2i(region_size, region_size);
 
 	// If no region and can't add one, skip whole function. Checked again later
 	Terrain3DData *data = _terrain->get_data();
@@ -108,7 +107,6 @@ void Terrain3DEditor::_operate_map(const Vector3 &p_global_position, const real_
 		LOG(ERROR, "Invalid brush image. Returning");
 		return;
 	}
-	Vector2i img_size = _brush_data["brush_image_size"];
 	real_t brush_size = _brush_data["size"];
 
 	// Typicall we multiply mouse pressure & strength setting, but
@@ -168,297 +166,465 @@ void Terrain3DEditor::_operate_map(const Vector3 &p_global_position, const real_
 	}
 
 	// MAP Operations
+	// Brush steps are one vertex apart, so the brush covers a square of map pixels in global space
 	real_t vertex_spacing = _terrain->get_mesh_vertex_spacing();
-	for (real_t x = 0.f; x < brush_size; x += vertex_spacing) {
-		for (real_t y = 0.f; y < brush_size; y += vertex_spacing) {
-			Vector2 brush_offset = Vector2(x, y) - (Vector2(brush_size, brush_size) / 2.f);
-			Vector3 brush_global_position =
-					Vector3(p_global_position.x + brush_offset.x + .5f, p_global_position.y,
-							p_global_position.z + brush_offset.y + .5f);
-
-			// Get region for current brush pixel global position
-			Vector2i region_loc = data->get_region_location(brush_global_position);
+	int steps = int(Math::ceil(brush_size / vertex_spacing));
+	Vector2 brush_corner = Vector2(p_global_position.x, p_global_position.z) -
+			Vector2(brush_size, brush_size) * .5f + Vector2(.5f, .5f);
+	Rect2i brush_rect = Rect2i(Vector2i((brush_corner / vertex_spacing).floor()), Vector2i(steps, steps));
+	_update_brush_mask(brush_image, MIN(steps, BRUSH_MASK_MAX_SIZE), gamma);
+
+	// Store settings for the tile workers
+	_stroke = Stroke();
+	_stroke.map_type = map_type;
+	_stroke.global_position = p_global_position;
+	_stroke.rect = brush_rect;
+	_stroke.brush_size = brush_size;
+	_stroke.vertex_spacing = vertex_spacing;
+	_stroke.rot = rot;
+	_stroke.strength = strength;
+	_stroke.height = height;
+	_stroke.color = color;
+	_stroke.roughness = roughness;
+	_stroke.enable_texture = enable_texture;
+	_stroke.asset_id = asset_id;
+	_stroke.enable_angle = enable_angle;
+	if (enable_angle && dynamic_angle) {
+		// Angle from mouse movement.
+		angle = Vector2(-_operation_movement.x, _operation_movement.z).angle();
+		// Avoid negative, align texture "up" with mouse direction.
+		angle = real_t(Math::fmod(Math::rad_to_deg(angle) + 450.f, 360.f));
+	}
+	_stroke.angle = angle;
+	_stroke.enable_scale = enable_scale;
+	_stroke.scale = scale;
+	_stroke.lift_flatten = lift_flatten;
+	_stroke.gradient_points = gradient_points;
+
+	// Prepare regions under the brush on the main thread. Add new regions and back up for undo
+	// before any pixels change. Then request write access, which detaches the maps from the
+	// undo copies, so workers can write to the raw pixel data without touching shared state.
+	Vector2i loc_min = _get_pixel_region_location(brush_rect.position, region_size);
+	Vector2i loc_max = _get_pixel_region_location(brush_rect.get_end() - Vector2i(1, 1), region_size);
+	for (int y = loc_min.y; y <= loc_max.y; y++) {
+		for (int x = loc_min.x; x <= loc_max.x; x++) {
+			Vector2i region_loc = Vector2i(x, y);
 			Ref<Terrain3DRegion> region = _operate_region(region_loc);
 			// If no region and can't make one, skip
 			if (region.is_null()) {
 				continue;
 			}
+			backup_region(region);
+			StrokeRegion &stroke_region = _stroke_regions[Terrain3DData::get_region_map_index(region_loc)];
+			stroke_region.region = region;
+			stroke_region.map = region->get_map(map_type)->ptrw();
+			stroke_region.height = region->get_height_map()->ptr();
+			stroke_region.half = is_half_height(region->get_height_map());
+		}
+	}
 
-			// Get map for this region and tool
-			Ref<Image> map = region->get_map(map_type);
+	// Split the brush into tiles aligned to BRUSH_TILE_SIZE, so each tile lies within one region
+	_stroke_tiles.clear();
+	Vector2i brush_end = brush_rect.get_end();
+	int tile_x = int(Math::floor(real_t(brush_rect.position.x) / real_t(BRUSH_TILE_SIZE))) * BRUSH_TILE_SIZE;
+	int tile_y = int(Math::floor(real_t(brush_rect.position.y) / real_t(BRUSH_TILE_SIZE))) * BRUSH_TILE_SIZE;
+	for (int y = tile_y; y < brush_end.y; y += BRUSH_TILE_SIZE) {
+		for (int x = tile_x; x < brush_end.x; x += BRUSH_TILE_SIZE) {
+			StrokeTile tile;
+			tile.rect = Rect2i(x, y, BRUSH_TILE_SIZE, BRUSH_TILE_SIZE).intersection(brush_rect);
+			tile.region_index = Terrain3DData::get_region_map_index(_get_pixel_region_location(tile.rect.position, region_size));
+			if (tile.region_index < 0 || _stroke_regions[tile.region_index].map == nullptr) {
+				continue;
+			}
+			_stroke_tiles.push_back(tile);
+		}
+	}
 
-			// Identify position on map image
-			Vector2 uv_position = _get_uv_position(brush_global_position, region_size, vertex_spacing);
-			Vector2i map_pixel_position = Vector2i(uv_position * region_size);
+	if (map_type == TYPE_HEIGHT && _operation == AVERAGE) {
+		_copy_average_heights();
+	}
 
-			if (_is_in_bounds(map_pixel_position, region_vsize)) {
-				Vector2 brush_uv = Vector2(x, y) / brush_size;
-				Vector2i brush_pixel_position = Vector2i(_get_rotated_uv(brush_uv, rot) * img_size);
+	// Small brushes run on this thread, large brushes are spread across the WorkerThreadPool
+	LOG(DEBUG_CONT, "Processing ", _stroke_tiles.size(), " brush tiles");
+	Util::run_group_task(callable_mp(this, &Terrain3DEditor::_operate_tile), _stroke_tiles.size(), "Terrain3D brush");
 
-				if (!_is_in_bounds(brush_pixel_position, img_size)) {
-					continue;
-				}
+	// Merge the height ranges and edited area from each tile
+	for (uint32_t i = 0; i < _stroke_tiles.size(); i++) {
+		const StrokeTile &tile = _stroke_tiles[i];
+		if (!tile.edited) {
+			continue;
+		}
+		Ref<Terrain3DRegion> region = _stroke_regions[tile.region_index].region;
+		if (map_type == TYPE_HEIGHT) {
+			region->update_heights(tile.height_range);
+			data->update_master_heights(tile.height_range);
+		}
+		region->mark_dirty(map_type, Rect2i(tile.rect.position - region->get_location() * region_size, tile.rect.size));
+		edited_area = edited_area.expand(Vector3(edited_area.position.x, tile.area_range.x, edited_area.position.z));
+		edited_area = edited_area.expand(Vector3(edited_area.position.x, tile.area_range.y, edited_area.position.z));
+	}
+
+	// Release references held for the workers, collecting the regions under the brush
+	TypedArray<Vector2i> region_locs;
+	for (StrokeRegion &stroke_region : _stroke_regions) {
+		if (stroke_region.region.is_valid()) {
+			Vector2i region_loc = stroke_region.region->get_location();
+			region_locs.push_back(region_loc);
+			// Regenerate color mipmaps only under the brush
+			if (map_type == TYPE_COLOR) {
+				Vector2i region_offset = region_loc * region_size;
+				Rect2i dirty_rect = brush_rect.intersection(Rect2i(region_offset, Vector2i(region_size, region_size)));
+				dirty_rect.position -= region_offset;
+				Util::update_mipmaps(stroke_region.region->get_color_map(), dirty_rect);
+			}
+		}
+		stroke_region = StrokeRegion();
+	}
+	_stroke_tiles.clear();
+	_stroke = Stroke();
 
-				Vector3 edited_position = brush_global_position;
-				edited_position.y = data->get_height(edited_position);
-				edited_area = edited_area.expand(edited_position);
+	// Upload only the edited layers
+	data->update_region_maps(map_type, region_locs);
+	data->add_edited_area(edited_area);
+}
 
-				// Start brushing on the map
-				real_t brush_alpha = brush_image->get_pixelv(brush_pixel_position).r;
-				brush_alpha = real_t(Math::pow(double(brush_alpha), double(gamma)));
-				Color src = map->get_pixelv(map_pixel_position);
-				Color dest = src;
+// Resamples the brush image to the brush size in pixels with gamma applied, so the tile workers
+// only need a bilinear lookup. Only rebuilt when the image, size or gamma change.
+void Terrain3DEditor::_update_brush_mask(const Ref<Image> &p_image, const int p_size, const real_t p_gamma) {
+	if (p_image == _brush_mask_image && p_size == _brush_mask_size && p_gamma == _brush_mask_gamma) {
+		return;
+	}
+	LOG(DEBUG, "Rebuilding brush mask: ", p_size, "x", p_size, ", gamma: ", p_gamma);
+	_brush_mask_image = p_image;
+	_brush_mask_size = p_size;
+	_brush_mask_gamma = p_gamma;
+
+	// Read the brush alpha from the red channel as floats
+	Ref<Image> img = p_image->duplicate();
+	if (img->is_compressed()) {
+		img->decompress();
+	}
+	img->convert(Image::FORMAT_RF);
+	Vector2i img_size = img->get_size();
+	const float *src = reinterpret_cast<const float *>(img->ptr());
+
+	_brush_mask.resize(p_size * p_size);
+	Vector2 scale = Vector2(img_size) / real_t(p_size);
+	for (int y = 0; y < p_size; y++) {
+		real_t sy = CLAMP((y + .5f) * scale.y - .5f, 0.f, real_t(img_size.y - 1));
+		int y0 = int(sy);
+		int y1 = MIN(y0 + 1, img_size.y - 1);
+		real_t fy = sy - y0;
+		for (int x = 0; x < p_size; x++) {
+			real_t sx = CLAMP((x + .5f) * scale.x - .5f, 0.f, real_t(img_size.x - 1));
+			int x0 = int(sx);
+			int x1 = MIN(x0 + 1, img_size.x - 1);
+			real_t fx = sx - x0;
+			real_t top = Math::lerp(src[y0 * img_size.x + x0], src[y0 * img_size.x + x1], fx);
+			real_t bottom = Math::lerp(src[y1 * img_size.x + x0], src[y1 * img_size.x + x1], fx);
+			real_t alpha = CLAMP(Math::lerp(top, bottom, fy), 0.f, 1.f);
+			_brush_mask[y * p_size + x] = real_t(Math::pow(double(alpha), double(p_gamma)));
+		}
+	}
+}
 
-				if (map_type == TYPE_HEIGHT) {
-					real_t srcf = src.r;
-					real_t destf = dest.r;
-
-					switch (_operation) {
-						case ADD: {
-							if (lift_flatten && !std::isnan(p_global_position.y)) {
-								real_t brush_center_y = p_global_position.y + brush_alpha * strength;
-								destf = Math::clamp(brush_center_y, srcf, srcf + brush_alpha * strength);
-							} else {
-								destf = srcf + (brush_alpha * strength);
-							}
-							break;
+// Applies the brush to one tile of the current stroke. Runs on the WorkerThreadPool so it only
+// reads _stroke and _stroke_regions, and only writes to its own tile and the pixels within it.
+void Terrain3DEditor::_operate_tile(const uint32_t p_index) {
+	StrokeTile &tile = _stroke_tiles[p_index];
+	const Stroke &stroke = _stroke;
+	const StrokeRegion &stroke_region = _stroke_regions[tile.region_index];
+	const int region_size = _terrain->get_region_size();
+	const Vector2i region_offset = _get_pixel_region_location(tile.rect.position, region_size) * region_size;
+	const Vector2i tile_end = tile.rect.get_end();
+	const Vector3 &global_position = stroke.global_position;
+
+	// Lookup to shift values saved to control map so that 0 (default) is the first entry
+	// Shader scale array is aligned to match this.
+	std::array<uint32_t, 8> scale_align = { 5, 6, 7, 0, 1, 2, 3, 4 };
+
+	for (int y = tile.rect.position.y; y < tile_end.y; y++) {
+		for (int x = tile.rect.position.x; x < tile_end.x; x++) {
+			Vector2 brush_offset = Vector2(x - stroke.rect.position.x, y - stroke.rect.position.y) * stroke.vertex_spacing;
+			// Sample the brush at the center of this step
+			Vector2 brush_uv = (brush_offset + Vector2(.5f, .5f) * stroke.vertex_spacing) / stroke.brush_size;
+			real_t brush_alpha = _get_brush_alpha(_get_rotated_uv(brush_uv, stroke.rot));
+			brush_offset -= Vector2(stroke.brush_size, stroke.brush_size) * .5f;
+			int ofs = (y - region_offset.y) * region_size + (x - region_offset.x);
+
+			real_t current_height = get_height_value(stroke_region.height, stroke_region.half, ofs);
+			if (!std::isnan(current_height)) {
+				tile.area_range.x = MIN(tile.area_range.x, current_height);
+				tile.area_range.y = MAX(tile.area_range.y, current_height);
+			}
+			tile.edited = true;
+
+			// Start brushing on the map
+			const real_t &strength = stroke.strength;
+
+			if (stroke.map_type == TYPE_HEIGHT) {
+				real_t srcf = get_height_value(stroke_region.map, stroke_region.half, ofs);
+				real_t destf = srcf;
+
+				switch (_operation) {
+					case ADD: {
+						if (stroke.lift_flatten && !std::isnan(global_position.y)) {
+							real_t brush_center_y = global_position.y + brush_alpha * strength;
+							destf = Math::clamp(brush_center_y, srcf, srcf + brush_alpha * strength);
+						} else {
+							destf = srcf + (brush_alpha * strength);
 						}
-						case SUBTRACT: {
-							if (lift_flatten && !std::isnan(p_global_position.y)) {
-								real_t brush_center_y = p_global_position.y - brush_alpha * strength;
-								destf = Math::clamp(brush_center_y, srcf - brush_alpha * strength, srcf);
-							} else {
-								destf = srcf - (brush_alpha * strength);
-							}
-							break;
+						break;
+					}
+					case SUBTRACT: {
+						if (stroke.lift_flatten && !std::isnan(global_position.y)) {
+							real_t brush_center_y = global_position.y - brush_alpha * strength;
+							destf = Math::clamp(brush_center_y, srcf - brush_alpha * strength, srcf);
+						} else {
+							destf = srcf - (brush_alpha * strength);
 						}
-						case REPLACE: {
-							destf = Math::lerp(srcf, height, brush_alpha * strength * .5f);
-							break;
+						break;
+					}
+					case REPLACE: {
+						destf = Math::lerp(srcf, stroke.height, brush_alpha * strength * .5f);
+						break;
+					}
+					case AVERAGE: {
+						// Read neighbors from the copy made before any tiles were processed
+						const Rect2i &rect = stroke.average_rect;
+						const float *center = stroke.average_heights.ptr() +
+								(y - rect.position.y) * rect.size.x + (x - rect.position.x);
+						real_t left = center[-1];
+						if (std::isnan(left)) {
+							left = 0.f;
 						}
-						case AVERAGE: {
-							Vector3 left_position = brush_global_position - Vector3(vertex_spacing, 0.f, 0.f);
-							Vector3 right_position = brush_global_position + Vector3(vertex_spacing, 0.f, 0.f);
-							Vector3 down_position = brush_global_position - Vector3(0.f, 0.f, vertex_spacing);
-							Vector3 up_position = brush_global_position + Vector3(0.f, 0.f, vertex_spacing);
-							real_t left = data->get_pixel(map_type, left_position).r;
-							if (std::isnan(left)) {
-								left = 0.f;
-							}
-							real_t right = data->get_pixel(map_type, right_position).r;
-							if (std::isnan(right)) {
-								right = 0.f;
-							}
-							real_t up = data->get_pixel(map_type, up_position).r;
-							if (std::isnan(up)) {
-								up = 0.f;
-							}
-							real_t down = data->get_pixel(map_type, down_position).r;
-							if (std::isnan(down)) {
-								down = 0.f;
-							}
-							real_t avg = (srcf + left + right + up + down) * 0.2f;
-							destf = Math::lerp(srcf, avg, CLAMP(brush_alpha * strength * 2.f, .02f, 1.f));
-							break;
+						real_t right = center[1];
+						if (std::isnan(right)) {
+							right = 0.f;
 						}
-						case GRADIENT: {
-							if (gradient_points.size() == 2) {
-								Vector3 point_1 = gradient_points[0];
-								Vector3 point_2 = gradient_points[1];
-
-								Vector2 point_1_xz = Vector2(point_1.x, point_1.z);
-								Vector2 point_2_xz = Vector2(point_2.x, point_2.z);
-								Vector2 brush_xz = Vector2(brush_global_position.x, brush_global_position.z);
-
-								if (_operation_movement.length_squared() > 0.f) {
-									// Ramp up/down only in the direction of movement, to avoid giving winding
-									// paths one edge higher than the other.
-									Vector2 movement_xz = Vector2(_operation_movement.x, _operation_movement.z).normalized();
-									Vector2 offset = movement_xz * Vector2(brush_offset).dot(movement_xz);
-									brush_xz = Vector2(p_global_position.x + offset.x, p_global_position.z + offset.y);
-								}
+						real_t up = center[rect.size.x];
+						if (std::isnan(up)) {
+							up = 0.f;
+						}
+						real_t down = center[-rect.size.x];
+						if (std::isnan(down)) {
+							down = 0.f;
+						}
+						real_t avg = (srcf + left + right + up + down) * 0.2f;
+						destf = Math::lerp(srcf, avg, CLAMP(brush_alpha * strength * 2.f, .02f, 1.f));
+						break;
+					}
+					case GRADIENT: {
+						if (stroke.gradient_points.size() == 2) {
+							Vector3 point_1 = stroke.gradient_points[0];
+							Vector3 point_2 = stroke.gradient_points[1];
+
+							Vector2 point_1_xz = Vector2(point_1.x, point_1.z);
+							Vector2 point_2_xz = Vector2(point_2.x, point_2.z);
+							Vector2 brush_xz = Vector2(global_position.x + brush_offset.x + .5f,
+									global_position.z + brush_offset.y + .5f);
+
+							if (_operation_movement.length_squared() > 0.f) {
+								// Ramp up/down only in the direction of movement, to avoid giving winding
+								// paths one edge higher than the other.
+								Vector2 movement_xz = Vector2(_operation_movement.x, _operation_movement.z).normalized();
+								Vector2 offset = movement_xz * brush_offset.dot(movement_xz);
+								brush_xz = Vector2(global_position.x + offset.x, global_position.z + offset.y);
+							}
 
-								Vector2 dir = point_2_xz - point_1_xz;
-								real_t weight = dir.normalized().dot(brush_xz - point_1_xz) / dir.length();
-								weight = Math::clamp(weight, (real_t)0.0f, (real_t)1.0f);
-								real_t height = Math::lerp(point_1.y, point_2.y, weight);
+							Vector2 dir = point_2_xz - point_1_xz;
+							real_t weight = dir.normalized().dot(brush_xz - point_1_xz) / dir.length();
+							weight = Math::clamp(weight, (real_t)0.0f, (real_t)1.0f);
+							real_t height = Math::lerp(point_1.y, point_2.y, weight);
 
-								destf = Math::lerp(srcf, height, brush_alpha * strength * .5f);
-							}
-							break;
+							destf = Math::lerp(srcf, height, brush_alpha * strength * .5f);
 						}
-						default:
-							break;
+						break;
 					}
-					dest = Color(destf, 0.f, 0.f, 1.f);
-					region->update_height(destf);
-					// TODO Move this line to a signal sent from above line
-					data->update_master_height(destf);
-
-					edited_position.y = destf;
-					edited_area = edited_area.expand(edited_position);
-
-				} else if (map_type == TYPE_CONTROL) {
-					// Get bit field from pixel
-					uint32_t base_id = get_base(src.r);
-					uint32_t overlay_id = get_overlay(src.r);
-					real_t blend = real_t(get_blend(src.r)) / 255.f;
-					uint32_t uvrotation = get_uv_rotation(src.r);
-					uint32_t uvscale = get_uv_scale(src.r);
-					bool hole = is_hole(src.r);
-					bool navigation = is_nav(src.r);
-					bool autoshader = is_auto(src.r);
-
-					real_t alpha_clip = (brush_alpha > 0.1f) ? 1.f : 0.f;
-					uint32_t dest_id = uint32_t(Math::lerp(base_id, asset_id, alpha_clip));
-					// Lookup to shift values saved to control map so that 0 (default) is the first entry
-					// Shader scale array is aligned to match this.
-					std::array<uint32_t, 8> scale_align = { 5, 6, 7, 0, 1, 2, 3, 4 };
-
-					switch (_tool) {
-						case TEXTURE:
-							switch (_operation) {
-								// Base Paint
-								case REPLACE: {
-									if (brush_alpha > 0.1f) {
-										if (enable_texture) {
-											// Set base texture
-											base_id = dest_id;
-											// Erase blend value
-											blend = Math::lerp(blend, real_t(0.f), alpha_clip);
-											autoshader = false;
-										}
-										// Set angle & scale
-										if (enable_angle) {
-											if (dynamic_angle) {
-												// Angle from mouse movement.
-												angle = Vector2(-_operation_movement.x, _operation_movement.z).angle();
-												// Avoid negative, align texture "up" with mouse direction.
-												angle = real_t(Math::fmod(Math::rad_to_deg(angle) + 450.f, 360.f));
-											}
-											// Convert from degrees to 0 - 15 value range
-											uvrotation = uint32_t(CLAMP(Math::round(angle / 22.5f), 0.f, 15.f));
-										}
-										if (enable_scale) {
-											// Offset negative and convert from percentage to 0 - 7 bit value range
-											// Maintain 0 = 0, remap negatives to end.
-											uvscale = scale_align[uint8_t(CLAMP(Math::round((scale + 60.f) / 20.f), 0.f, 7.f))];
-										}
-									}
-									break;
-								}
-
-								// Overlay Spray
-								case ADD: {
-									real_t spray_strength = CLAMP(strength * 0.05f, 0.003f, .25f);
-									real_t brush_value = CLAMP(brush_alpha * spray_strength, 0.f, 1.f);
-									if (enable_texture) {
-										// If overlay and base texture are the same, reduce blend value
-										if (dest_id == base_id) {
-											blend = CLAMP(blend - brush_value, 0.f, 1.f);
-										} else {
-											// Else overlay and base are separate, set overlay texture and increase blend value
-											overlay_id = dest_id;
-											blend = CLAMP(blend + brush_value, 0.f, 1.f);
-										}
+					default:
+						break;
+				}
+				set_height_value(stroke_region.map, stroke_region.half, ofs, destf);
+				tile.height_range.x = MIN(tile.height_range.x, destf);
+				tile.height_range.y = MAX(tile.height_range.y, destf);
+				tile.area_range.x = MIN(tile.area_range.x, destf);
+				tile.area_range.y = MAX(tile.area_range.y, destf);
+
+			} else if (stroke.map_type == TYPE_CONTROL) {
+				float *pixel = reinterpret_cast<float *>(stroke_region.map) + ofs;
+				float src = *pixel;
+
+				// Get bit field from pixel
+				uint32_t base_id = get_base(src);
+				uint32_t overlay_id = get_overlay(src);
+				real_t blend = real_t(get_blend(src)) / 255.f;
+				uint32_t uvrotation = get_uv_rotation(src);
+				uint32_t uvscale = get_uv_scale(src);
+				bool hole = is_hole(src);
+				bool navigation = is_nav(src);
+				bool autoshader = is_auto(src);
+
+				real_t alpha_clip = (brush_alpha > 0.1f) ? 1.f : 0.f;
+				uint32_t dest_id = uint32_t(Math::lerp(base_id, stroke.asset_id, alpha_clip));
+
+				switch (_tool) {
+					case TEXTURE:
+						switch (_operation) {
+							// Base Paint
+							case REPLACE: {
+								if (brush_alpha > 0.1f) {
+									if (stroke.enable_texture) {
+										// Set base texture
+										base_id = dest_id;
+										// Erase blend value
+										blend = Math::lerp(blend, real_t(0.f), alpha_clip);
 										autoshader = false;
 									}
-									if (brush_alpha * strength * 11.f > 0.1f) {
-										// Set angle & scale
-										if (enable_angle) {
-											if (dynamic_angle) {
-												// Angle from mouse movement.
-												angle = Vector2(-_operation_movement.x, _operation_movement.z).angle();
-												// Avoid negative, align texture "up" with mouse direction.
-												angle = real_t(Math::fmod(Math::rad_to_deg(angle) + 450.f, 360.f));
-											}
-											// Convert from degrees to 0 - 15 value range
-											uvrotation = uint32_t(CLAMP(Math::round(angle / 22.5f), 0.f, 15.f));
-										}
-										if (enable_scale) {
-											// Offset negative and convert from percentage to 0 - 7 bit value range
-											// Maintain 0 = 0, remap negatives to end.
-											uvscale = scale_align[uint8_t(CLAMP(Math::round((scale + 60.f) / 20.f), 0.f, 7.f))];
-										}
+									// Set angle & scale
+									if (stroke.enable_angle) {
+										// Convert from degrees to 0 - 15 value range
+										uvrotation = uint32_t(CLAMP(Math::round(stroke.angle / 22.5f), 0.f, 15.f));
+									}
+									if (stroke.enable_scale) {
+										// Offset negative and convert from percentage to 0 - 7 bit value range
+										// Maintain 0 = 0, remap negatives to end.
+										uvscale = scale_align[uint8_t(CLAMP(Math::round((stroke.scale + 60.f) / 20.f), 0.f, 7.f))];
 									}
-									break;
 								}
+								break;
+							}
 
-								default: {
-									break;
+							// Overlay Spray
+							case ADD: {
+								real_t spray_strength = CLAMP(strength * 0.05f, 0.003f, .25f);
+								real_t brush_value = CLAMP(brush_alpha * spray_strength, 0.f, 1.f);
+								if (stroke.enable_texture) {
+									// If overlay and base texture are the same, reduce blend value
+									if (dest_id == base_id) {
+										blend = CLAMP(blend - brush_value, 0.f, 1.f);
+									} else {
+										// Else overlay and base are separate, set overlay texture and increase blend value
+										overlay_id = dest_id;
+										blend = CLAMP(blend + brush_value, 0.f, 1.f);
+									}
+									autoshader = false;
+								}
+								if (brush_alpha * strength * 11.f > 0.1f) {
+									// Set angle & scale
+									if (stroke.enable_angle) {
+										// Convert from degrees to 0 - 15 value range
+										uvrotation = uint32_t(CLAMP(Math::round(stroke.angle / 22.5f), 0.f, 15.f));
+									}
+									if (stroke.enable_scale) {
+										// Offset negative and convert from percentage to 0 - 7 bit value range
+										// Maintain 0 = 0, remap negatives to end.
+										uvscale = scale_align[uint8_t(CLAMP(Math::round((stroke.scale + 60.f) / 20.f), 0.f, 7.f))];
+									}
 								}
+								break;
 							}
-							break;
-						case AUTOSHADER: {
-							if (brush_alpha > 0.1f) {
-								autoshader = (_operation == ADD);
+
+							default: {
+								break;
 							}
-							break;
 						}
-						case HOLES: {
-							if (brush_alpha > 0.1f) {
-								hole = (_operation == ADD);
-							}
-							break;
+						break;
+					case AUTOSHADER: {
+						if (brush_alpha > 0.1f) {
+							autoshader = (_operation == ADD);
 						}
-						case NAVIGATION: {
-							if (brush_alpha > 0.1f) {
-								navigation = (_operation == ADD);
-							}
-							break;
+						break;
+					}
+					case HOLES: {
+						if (brush_alpha > 0.1f) {
+							hole = (_operation == ADD);
 						}
-						default: {
-							break;
+						break;
+					}
+					case NAVIGATION: {
+						if (brush_alpha > 0.1f) {
+							navigation = (_operation == ADD);
 						}
+						break;
 					}
-
-					// Convert back to bitfield
-					uint32_t blend_int = uint32_t(CLAMP(Math::round(blend * 255.f), 0.f, 255.f));
-					uint32_t bits = enc_base(base_id) | enc_overlay(overlay_id) |
-							enc_blend(blend_int) | enc_uv_rotation(uvrotation) |
-							enc_uv_scale(uvscale) | enc_hole(hole) |
-							enc_nav(navigation) | enc_auto(autoshader);
-
-					// Write back to pixel in FORMAT_RF. Must be a 32-bit float
-					dest = Color(as_float(bits), 0.f, 0.f, 1.f);
-
-				} else if (map_type == TYPE_COLOR) {
-					switch (_tool) {
-						case COLOR:
-							dest = src.lerp((_operation == ADD) ? color : COLOR_WHITE, brush_alpha * strength);
-							dest.a = src.a;
-							break;
-						case ROUGHNESS:
-							/* Roughness received from UI is -100 to 100. Changed to 0,1 before storing.
-							 * To convert 0,1 back to -100,100 use: 200 * (color.a - 0.5)
-							 * However Godot stores values as 8-bit ints. Roundtrip is = int(a*255)/255.0
-							 * Roughness 0 is saved as 0.5, but retreived is 0.498, or -0.4 roughness
-							 * We round the final amount in tool_settings.gd:_on_picked().
-							 */
-							if (_operation == ADD) {
-								dest.a = Math::lerp(real_t(src.a), real_t(.5f + .5f * roughness), brush_alpha * strength);
-							} else {
-								dest.a = Math::lerp(real_t(src.a), real_t(.5f + .5f * 0.5f), brush_alpha * strength);
-							}
-							break;
-						default:
-							break;
+					default: {
+						break;
 					}
 				}
-				backup_region(region);
-				map->set_pixelv(map_pixel_position, dest);
+
+				// Convert back to bitfield
+				uint32_t blend_int = uint32_t(CLAMP(Math::round(blend * 255.f), 0.f, 255.f));
+				uint32_t bits = enc_base(base_id) | enc_overlay(overlay_id) |
+						enc_blend(blend_int) | enc_uv_rotation(uvrotation) |
+						enc_uv_scale(uvscale) | enc_hole(hole) |
+						enc_nav(navigation) | enc_auto(autoshader);
+
+				// Write back to pixel in FORMAT_RF. Must be a 32-bit float
+				*pixel = as_float(bits);
+
+			} else if (stroke.map_type == TYPE_COLOR) {
+				// FORMAT_RGBA8, converted the same as Image::get_pixel() and set_pixel()
+				uint8_t *pixel = stroke_region.map + ofs * 4;
+				Color src = Color(pixel[0] / 255.f, pixel[1] / 255.f, pixel[2] / 255.f, pixel[3] / 255.f);
+				Color dest = src;
+				switch (_tool) {
+					case COLOR:
+						dest = src.lerp((_operation == ADD) ? stroke.color : COLOR_WHITE, brush_alpha * strength);
+						dest.a = src.a;
+						break;
+					case ROUGHNESS:
+						/* Roughness received from UI is -100 to 100. Changed to 0,1 before storing.
+						 * To convert 0,1 back to -100,100 use: 200 * (color.a - 0.5)
+						 * However Godot stores values as 8-bit ints. Roundtrip is = int(a*255)/255.0
+						 * Roughness 0 is saved as 0.5, but retreived is 0.498, or -0.4 roughness
+						 * We round the final amount in tool_settings.gd:_on_picked().
+						 */
+						if (_operation == ADD) {
+							dest.a = Math::lerp(real_t(src.a), real_t(.5f + .5f * stroke.roughness), brush_alpha * strength);
+						} else {
+							dest.a = Math::lerp(real_t(src.a), real_t(.5f + .5f * 0.5f), brush_alpha * strength);
+						}
+						break;
+					default:
+						break;
+				}
+				pixel[0] = uint8_t(CLAMP(dest.r * 255.f, 0.f, 255.f));
+				pixel[1] = uint8_t(CLAMP(dest.g * 255.f, 0.f, 255.f));
+				pixel[2] = uint8_t(CLAMP(dest.b * 255.f, 0.f, 255.f));
+				pixel[3] = uint8_t(CLAMP(dest.a * 255.f, 0.f, 255.f));
 			}
 		}
 	}
-	// Regenerate color mipmaps for edited regions
-	if (map_type == TYPE_COLOR) {
-		for (int i = 0; i < _edited_regions.size(); i++) {
-			Ref<Terrain3DRegion> region = _edited_regions[i];
-			region->get_map(map_type)->generate_mipmaps();
+}
+
+// Copies the height map under the brush plus a 1 pixel border, so AVERAGE reads the original
+// neighbors regardless of the order tiles are processed. Missing regions are copied as 0.
+void Terrain3DEditor::_copy_average_heights() {
+	Terrain3DData *data = _terrain->get_data();
+	int region_size = _terrain->get_region_size();
+	Rect2i rect = _stroke.rect.grow(1);
+	_stroke.average_rect = rect;
+	_stroke.average_heights.resize(rect.size.x * rect.size.y);
+	float *dst = _stroke.average_heights.ptr();
+	for (int y = 0; y < rect.size.y; y++) {
+		int x = 0;
+		while (x < rect.size.x) {
+			Vector2i pixel = rect.position + Vector2i(x, y);
+			Vector2i region_loc = _get_pixel_region_location(pixel, region_size);
+			// Copy the row up to the edge of this region
+			int count = MIN(rect.size.x - x, (region_loc.x + 1) * region_size - pixel.x);
+			float *row = dst + y * rect.size.x + x;
+			Ref<Terrain3DRegion> region = data->get_region(region_loc);
+			if (region.is_valid()) {
+				Vector2i img_pos = pixel - region_loc * region_size;
+				Ref<Image> height_map = region->get_height_map();
+				get_height_values(height_map->ptr(), is_half_height(height_map), img_pos.y * region_size + img_pos.x, row, count);
+			} else {
+				memset(row, 0, count * sizeof(float));
+			}
+			x += count;
 		}
 	}
-	data->force_update_maps(map_type);
-	data->add_edited_area(edited_area);
 }
 
 void Terrain3DEditor::_store_undo() {
@@ -534,7 +700,8 @@ void Terrain3DEditor::_apply_undo(const Dictionary &p_data) {
 			region->sanitize_maps(); // Live data may not have some maps so must be sanitized
 			Dictionary regions = data->get_regions_all();
 			regions[region->get_location()] = region;
-			region->set_modified(true);
+			// The file may hold either state, so all of the region is saved
+			region->mark_dirty();
 			LOG(DEBUG, "Edited: ", region->get_data());
 		}
 	}
@@ -692,6 +859,9 @@ void Terrain3DEditor::operate(const Vector3 &p_global_position, const real_t p_c
 void Terrain3DEditor::backup_region(const Ref<Terrain3DRegion> &p_region) {
 	if (_is_operating && p_region.is_valid() && !p_region->is_edited()) {
 		LOG(DEBUG, "Storing original copy of region: ", p_region->get_location());
+		// Maps left out by Terrain3D.resident_maps are read first, so undo and redo never hold
+		// blank placeholders that would be saved over the real maps
+		p_region->load_maps();
 		_original_regions.push_back(p_region->duplicate(true));
 		_edited_regions.push_back(p_region);
 		p_region->set_edited(true);
@@ -5,6 +5,7 @@
 
 #include <godot_cpp/classes/image.hpp>
 #include <godot_cpp/classes/image_texture.hpp>
+#include <godot_cpp/templates/local_vector.hpp>
 
 #include "terrain_3d.h"
 #include "terrain_3d_region.h"
@@ -64,7 +65,54 @@ public: // Constants
 		"TOOL_MAX",
 	};
 
+	// Brush strokes are split into tiles of this size, in pixels, and processed on the WorkerThreadPool
+	static inline const int BRUSH_TILE_SIZE = 64;
+	// Limits the memory used by the cached brush mask. Larger brushes are bilinearly upscaled
+	static inline const int BRUSH_MASK_MAX_SIZE = 2048;
+
 private:
+	// Raw pointers to the maps of one region, built on the main thread for the tile workers
+	struct StrokeRegion {
+		Ref<Terrain3DRegion> region;
+		uint8_t *map = nullptr; // Map being edited
+		const uint8_t *height = nullptr; // Height map, for edited_area
+		bool half = false; // Height map format, see is_half_height()
+	};
+
+	// A tile of the brush footprint. Tiles are aligned to BRUSH_TILE_SIZE so each lies in one region.
+	struct StrokeTile {
+		Rect2i rect; // In global pixel coordinates
+		int region_index = -1; // Index into _stroke_regions, per Terrain3DData::get_region_map_index()
+		bool edited = false;
+		Vector2 height_range = Vector2(FLT_MAX, -FLT_MAX); // Of new heights, for the region height range
+		Vector2 area_range = Vector2(FLT_MAX, -FLT_MAX); // Of all heights touched, for edited_area
+	};
+
+	// Brush settings for the current operation, read only while tiles are processed
+	struct Stroke {
+		MapType map_type = TYPE_MAX;
+		Vector3 global_position;
+		Rect2i rect; // Brush footprint in global pixel coordinates
+		real_t brush_size = 0.f;
+		real_t vertex_spacing = 1.f;
+		real_t rot = 0.f;
+		real_t strength = 0.f;
+		real_t height = 0.f;
+		Color color;
+		real_t roughness = 0.f;
+		bool enable_texture = true;
+		int asset_id = 0;
+		bool enable_angle = true;
+		real_t angle = 0.f;
+		bool enable_scale = true;
+		real_t scale = 0.f;
+		bool lift_flatten = false;
+		PackedVector3Array gradient_points;
+		// Copy of the height map around the footprint, read by AVERAGE so tiles don't see each other's writes
+		Rect2i average_rect;
+		LocalVector<float> average_heights;
+	};
+
 	Terrain3D *_terrain = nullptr;
 
 	// Painter settings & variables
@@ -83,13 +131,29 @@ private:
 	Dictionary _undo_data; // See _get_undo_data for definition
 	uint64_t _last_pen_tick = 0;
 
+	// Current brush stroke, see _operate_map()
+	Stroke _stroke;
+	StrokeRegion _stroke_regions[Terrain3DData::REGION_MAP_SIZE * Terrain3DData::REGION_MAP_SIZE];
+	LocalVector<StrokeTile> _stroke_tiles;
+
+	// Brush alpha resampled to the brush size in pixels w/ gamma applied, see _update_brush_mask()
+	LocalVector<float> _brush_mask;
+	int _brush_mask_size = 0;
+	Ref<Image> _brush_mask_image;
+	real_t _brush_mask_gamma = 0.f;
+
 	void _send_region_aabb(const Vector2i &p_region_loc, const Vector2 &p_height_range = Vector2());
 	Ref<Terrain3DRegion> _operate_region(const Vector2i &p_region_loc);
 	void _operate_map(const Vector3 &p_global_position, const real_t p_camera_direction);
+	void _operate_tile(const uint32_t p_index);
+	void _copy_average_heights();
+	void _update_brush_mask(const Ref<Image> &p_image, const int p_size, const real_t p_gamma);
 	MapType _get_map_type() const;
 	bool _is_in_bounds(const Vector2i &p_position, const Vector2i &p_max_position) const;
 	Vector2 _get_uv_position(const Vector3 &p_global_position, const int p_region_size, const real_t p_vertex_spacing) const;
 	Vector2 _get_rotated_uv(const Vector2 &p_uv, const real_t p_angle) const;
+	real_t _get_brush_alpha(const Vector2 &p_uv) const;
+	Vector2i _get_pixel_region_location(const Vector2i &p_pixel, const int p_region_size) const;
 
 	void _store_undo();
 	void _apply_undo(const Dictionary &p_data);
@@ -165,4 +229,26 @@ inline Vector2 Terrain3DEditor::_get_rotated_uv(const Vector2 &p_uv, const real_
 	return uv.clamp(V2_ZERO, Vector2(1.f, 1.f));
 }
 
+// Bilinearly samples the brush mask at a 0-1 uv position
+inline real_t Terrain3DEditor::_get_brush_alpha(const Vector2 &p_uv) const {
+	const int size = _brush_mask_size;
+	const float *mask = _brush_mask.ptr();
+	real_t x = CLAMP(p_uv.x * size - .5f, 0.f, real_t(size - 1));
+	real_t y = CLAMP(p_uv.y * size - .5f, 0.f, real_t(size - 1));
+	int x0 = int(x);
+	int y0 = int(y);
+	int x1 = MIN(x0 + 1, size - 1);
+	int y1 = MIN(y0 + 1, size - 1);
+	real_t top = Math::lerp(mask[y0 * size + x0], mask[y0 * size + x1], x - x0);
+	real_t bottom = Math::lerp(mask[y1 * size + x0], mask[y1 * size + x1], x - x0);
+	return Math::lerp(top, bottom, y - y0);
+}
+
+// Returns the region location of a global pixel position, flooring negative values
+inline Vector2i Terrain3DEditor::_get_pixel_region_location(const Vector2i &p_pixel, const int p_region_size) const {
+	int x = (p_pixel.x >= 0) ? p_pixel.x / p_region_size : (p_pixel.x + 1) / p_region_size - 1;
+	int y = (p_pixel.y >= 0) ? p_pixel.y / p_region_size : (p_pixel.y + 1) / p_region_size - 1;
+	return Vector2i(x, y);
+}
+
 #endif // TERRAIN3D_EDITOR_CLASS_H
@@ -1,6 +1,10 @@
 // Copyright © 2024 Cory Petkovsek, Roope Palmroos, and Contributors.
 
+#include <godot_cpp/classes/display_server.hpp>
+#include <godot_cpp/classes/physics_server3d.hpp>
+#include <godot_cpp/classes/rendering_server.hpp>
 #include <godot_cpp/classes/resource_saver.hpp>
+#include <godot_cpp/classes/world3d.hpp>
 
 #include "logger.h"
 #include "terrain_3d_instancer.h"
@@ -11,17 +15,222 @@
 // Private Functions
 ///////////////////////////
 
+// Returns the cell containing a global position, indexed from its region origin
+Vector2i Terrain3DInstancer::_get_cell(const Vector3 &p_global_position, const int p_region_size) const {
+	Vector2 descaled_position = Vector2(p_global_position.x, p_global_position.z) / _terrain->get_mesh_vertex_spacing();
+	Vector2 region_position = descaled_position - (descaled_position / real_t(p_region_size)).floor() * real_t(p_region_size);
+	int max_cell = p_region_size / CELL_SIZE - 1;
+	return Vector2i(region_position / real_t(CELL_SIZE)).clamp(V2I_ZERO, Vector2i(max_cell, max_cell));
+}
+
+// Finds the cell MultiMeshes overlapping a global rect, for one mesh id or all if -1
+// The cells form a uniform grid, so only the cells under the rect are looked up
+void Terrain3DInstancer::_find_cells(const Rect2 &p_rect, const int p_mesh_id, LocalVector<CellRef> &r_cells) const {
+	Terrain3DData *data = _terrain->get_data();
+	int region_size = _terrain->get_region_size();
+	int cells_per_side = region_size / CELL_SIZE;
+	real_t cell_width = _terrain->get_mesh_vertex_spacing() * CELL_SIZE;
+	Vector2i cell_min = Vector2i((p_rect.position / cell_width).floor());
+	Vector2i cell_max = Vector2i((p_rect.get_end() / cell_width).floor());
+	Vector2i loc_min = Vector2i((Vector2(cell_min) / real_t(cells_per_side)).floor());
+	Vector2i loc_max = Vector2i((Vector2(cell_max) / real_t(cells_per_side)).floor());
+	Vector2i last_cell = Vector2i(cells_per_side - 1, cells_per_side - 1);
+
+	for (int ly = loc_min.y; ly <= loc_max.y; ly++) {
+		for (int lx = loc_min.x; lx <= loc_max.x; lx++) {
+			Vector2i region_loc = Vector2i(lx, ly);
+			if (!data->has_region(region_loc)) {
+				continue;
+			}
+			Ref<Terrain3DRegion> region = data->get_region(region_loc);
+			Dictionary mesh_dict = region->get_multimeshes();
+			Array mesh_types;
+			if (p_mesh_id < 0) {
+				mesh_types = mesh_dict.keys();
+			} else {
+				mesh_types.push_back(p_mesh_id);
+			}
+			// Range of cells under the rect in this region
+			Vector2i cell_offset = region_loc * cells_per_side;
+			Vector2i start = (cell_min - cell_offset).clamp(V2I_ZERO, last_cell);
+			Vector2i end = (cell_max - cell_offset).clamp(V2I_ZERO, last_cell);
+			for (int m = 0; m < mesh_types.size(); m++) {
+				int mesh_id = mesh_types[m];
+				Dictionary cell_dict = mesh_dict.get(mesh_id, Dictionary());
+				if (cell_dict.is_empty()) {
+					continue;
+				}
+				for (int y = start.y; y <= end.y; y++) {
+					for (int x = start.x; x <= end.x; x++) {
+						Vector2i cell = Vector2i(x, y);
+						Ref<MultiMesh> mm = cell_dict.get(cell, Ref<MultiMesh>());
+						if (mm.is_valid()) {
+							CellRef cell_ref;
+							cell_ref.region = region;
+							cell_ref.mesh_id = mesh_id;
+							cell_ref.cell = cell;
+							cell_ref.mm = mm;
+							r_cells.push_back(cell_ref);
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+// Reads the transform and color settings shared by add_instances() and scatter()
+Terrain3DInstancer::InstanceParams Terrain3DInstancer::_get_instance_params(const Dictionary &p_params) const {
+	InstanceParams params;
+	params.fixed_scale = CLAMP(real_t(p_params.get("fixed_scale", 100.f)) * .01f, .01f, 100.f); // 1-10k%
+	params.random_scale = CLAMP(real_t(p_params.get("random_scale", 0.f)) * .01f, 0.f, 10.f); // +/- 1000%
+	params.fixed_spin = CLAMP(real_t(p_params.get("fixed_spin", 0.f)), .0f, 360.f); // degrees
+	params.random_spin = CLAMP(real_t(p_params.get("random_spin", 360.f)), 0.f, 360.f); // degrees
+	params.fixed_angle = CLAMP(real_t(p_params.get("fixed_angle", 0.f)), -180.f, 180.f); // degrees
+	params.random_angle = CLAMP(real_t(p_params.get("random_angle", 10.f)), 0.f, 180.f); // degrees
+	params.align_to_normal = bool(p_params.get("align_to_normal", false));
+	params.height_offset = CLAMP(real_t(p_params.get("height_offset", 0.f)), -100.0f, 100.f); // meters
+	params.random_height = CLAMP(real_t(p_params.get("random_height", 0.f)), 0.f, 100.f); // meters
+	params.vertex_color = Color(p_params.get("vertex_color", COLOR_WHITE));
+	params.random_hue = CLAMP(real_t(p_params.get("random_hue", 0.f)) / 360.f, 0.f, 1.f); // degrees -> 0-1
+	params.random_darken = CLAMP(real_t(p_params.get("random_darken", 0.f)) * .01f, 0.f, 1.f); // 0-100%
+	return params;
+}
+
+// Builds the transform and color of an instance on the terrain at p_position, randomized by p_state
+// Safe to call from worker threads. The normal is only used when aligning to it and may be NAN.
+void Terrain3DInstancer::_randomize_instance(const InstanceParams &p_params, const Vector3 &p_position, const Vector3 &p_normal,
+		uint32_t &p_state, Transform3D &r_xform, Color &r_color) const {
+	Transform3D t;
+
+	// Orientation
+	Vector3 normal = Vector3(0.f, 1.f, 0.f);
+	if (p_params.align_to_normal && !std::isnan(p_normal.x)) {
+		normal = p_normal.normalized();
+		Vector3 z_axis = Vector3(0.f, 0.f, 1.f);
+		Vector3 x_axis = -z_axis.cross(normal);
+		t.basis = Basis(x_axis, normal, z_axis).orthonormalized();
+	}
+	real_t spin = (p_params.fixed_spin + p_params.random_spin * rand_float(p_state)) * Math_PI / 180.f;
+	if (abs(spin) > 0.001f) {
+		t.basis = t.basis.rotated(normal, spin);
+	}
+	real_t angle = (p_params.fixed_angle + p_params.random_angle * (2.f * rand_float(p_state) - 1.f)) * Math_PI / 180.f;
+	if (abs(angle) > 0.001f) {
+		t.basis = t.basis.rotated(t.basis.get_column(0), angle); // Rotate pitch, X-axis
+	}
+
+	// Scale
+	real_t t_scale = CLAMP(p_params.fixed_scale + p_params.random_scale * (2.f * rand_float(p_state) - 1.f), 0.01f, 10.f);
+	t = t.scaled(Vector3(t_scale, t_scale, t_scale));
+
+	// Position. mesh_asset height offset added by the caller
+	real_t offset = p_params.height_offset + p_params.random_height * (2.f * rand_float(p_state) - 1.f);
+	Vector3 position = p_position + t.basis.get_column(1) * offset; // Offset along UP axis
+	r_xform = t.translated(position);
+
+	// Color
+	r_color = p_params.vertex_color;
+	r_color.set_v(CLAMP(r_color.get_v() - p_params.random_darken * rand_float(p_state), 0.f, 1.f));
+	r_color.set_h(fmod(r_color.get_h() + p_params.random_hue * (2.f * rand_float(p_state) - 1.f), 1.f));
+}
+
+// Returns the interpolated height at a global position in the tile's region, or NAN in holes
+// Positions on the last row or column of the region read across the border through Terrain3DData
+real_t Terrain3DInstancer::_get_scatter_height(const ScatterTile &p_tile, const Vector3 &p_global_position) const {
+	int size = _scatter.region_size;
+	Vector2 px = Vector2(p_global_position.x, p_global_position.z) / _scatter.vertex_spacing - Vector2(p_tile.region_offset);
+	int x = int(Math::floor(px.x));
+	int y = int(Math::floor(px.y));
+	if (x < 0 || y < 0 || x + 1 >= size || y + 1 >= size) {
+		return _terrain->get_data()->get_height(p_global_position);
+	}
+	if (is_hole(p_tile.control[y * size + x])) {
+		return NAN;
+	}
+	int64_t i = int64_t(y) * size + x;
+	real_t h00 = get_height_value(p_tile.height, p_tile.half, i);
+	real_t h01 = get_height_value(p_tile.height, p_tile.half, i + 1);
+	real_t h10 = get_height_value(p_tile.height, p_tile.half, i + size);
+	real_t h11 = get_height_value(p_tile.height, p_tile.half, i + size + 1);
+	real_t fx = px.x - x;
+	real_t fy = px.y - y;
+	return Math::lerp(Math::lerp(h00, h01, fx), Math::lerp(h10, h11, fx), fy);
+}
+
+// Fills one tile of scatter() on a worker thread. Points lie on a jittered grid in global space, each
+// seeded by its grid position, so the result is the same regardless of tiling or thread count.
+void Terrain3DInstancer::_scatter_tile(const uint32_t p_index) {
+	ScatterTile &tile = _scatter.tiles[p_index];
+	const ScatterJob &job = _scatter;
+	const int size = job.region_size;
+	const real_t step = job.vertex_spacing;
+	Vector2i grid_min = Vector2i((tile.rect.position / job.spacing).floor());
+	Vector2i grid_max = Vector2i((tile.rect.get_end() / job.spacing).floor());
+
+	for (int gy = grid_min.y; gy <= grid_max.y; gy++) {
+		for (int gx = grid_min.x; gx <= grid_max.x; gx++) {
+			uint32_t state = hash32(job.seed ^ hash32(uint32_t(gx) ^ hash32(uint32_t(gy))));
+			Vector2 jitter = Vector2(rand_float(state) - .5f, rand_float(state) - .5f) * job.jitter;
+			Vector2 pos2d = (Vector2(gx, gy) + Vector2(.5f, .5f) + jitter) * job.spacing;
+			// Tiles don't overlap, so each point is placed by only one tile
+			if (!tile.rect.has_point(pos2d)) {
+				continue;
+			}
+
+			// Height band, skipping holes
+			Vector3 position = Vector3(pos2d.x, 0.f, pos2d.y);
+			real_t height = _get_scatter_height(tile, position);
+			if (std::isnan(height) || height < job.height_min || height > job.height_max) {
+				continue;
+			}
+			position.y = height;
+
+			// Navigation and texture rules from the control map
+			Vector2i px = (Vector2i((pos2d / step).floor()) - tile.region_offset).clamp(V2I_ZERO, Vector2i(size - 1, size - 1));
+			uint32_t control = tile.control[px.y * size + px.x];
+			if ((job.navigation == 1 && !is_nav(control)) || (job.navigation == 2 && is_nav(control))) {
+				continue;
+			}
+			if (job.texture_mask != 0) {
+				real_t blend = real_t(get_blend(control)) / 255.f;
+				real_t weight = 0.f;
+				if (job.texture_mask & (1u << get_base(control))) {
+					weight += 1.f - blend;
+				}
+				if (job.texture_mask & (1u << get_overlay(control))) {
+					weight += blend;
+				}
+				if (weight < job.texture_threshold) {
+					continue;
+				}
+			}
+
+			// Slope, w/ the normal calculated as in Terrain3DData::get_normal()
+			real_t height_x = _get_scatter_height(tile, position + Vector3(step, 0.f, 0.f));
+			real_t height_z = _get_scatter_height(tile, position + Vector3(0.f, 0.f, step));
+			Vector3 normal = Vector3(height - height_x, step, height - height_z).normalized();
+			if (std::isnan(normal.y) || normal.y > job.cos_slope_min || normal.y < job.cos_slope_max) {
+				continue;
+			}
+
+			Transform3D t;
+			Color col;
+			_randomize_instance(job.params, position, normal, state, t, col);
+			t.origin += t.basis.get_column(1) * job.mesh_height_offset; // Offset along UP axis
+			tile.xforms.push_back(t);
+			tile.colors.push_back(col);
+		}
+	}
+}
+
 // Creates MMIs based on stored Multimesh data
 void Terrain3DInstancer::_update_mmis(const Vector2i &p_region_loc, const int p_mesh_id) {
 	IS_DATA_INIT(VOID);
 	LOG(INFO, "Updating MMIs for ", (p_region_loc.x == INT32_MAX) ? "all regions" : "region " + String(p_region_loc),
 			(p_mesh_id == -1) ? ", all meshes" : ", mesh " + String::num_int64(p_mesh_id));
-	if (_mmis.has(Variant())) {
-		_mmis.erase(Variant());
-		LOG(WARN, "Removed errant null in MMI dictionary");
-	}
-
 	// For specified region_location, or max for all
+	int cells_per_side = _terrain->get_region_size() / CELL_SIZE;
 	Array region_locations;
 	if (p_region_loc.x == INT32_MAX) {
 		region_locations = _terrain->get_data()->get_region_locations();
@@ -51,18 +260,20 @@ void Terrain3DInstancer::_update_mmis(const Vector2i &p_region_loc, const int p_
 
 			/// Verify the Multimesh data
 
-			// Verify Multimesh exists. It should since its keyed
-			Ref<MultiMesh> mm = mesh_dict.get(mesh_id, Ref<MultiMesh>());
-			if (mm.is_null()) {
-				LOG(DEBUG, "Dictionary for mesh id ", mesh_id, " is null, skipping");
+			// Data saved before cells has one MultiMesh per mesh id
+			if (mesh_dict.get(mesh_id, Variant()).get_type() == Variant::OBJECT) {
+				_upgrade_multimesh(region, mesh_id);
+			}
+			// Verify cells exist. They should since its keyed
+			Dictionary cell_dict = mesh_dict.get(mesh_id, Dictionary());
+			if (cell_dict.is_empty()) {
+				LOG(DEBUG, "Dictionary for mesh id ", mesh_id, " is empty, skipping");
 				fail = true;
 			}
 			// Verify mesh id is valid and has a mesh
 			Ref<Terrain3DMeshAsset> ma = _terrain->get_assets()->get_mesh_asset(mesh_id);
-			Ref<Mesh> mesh;
 			if (ma.is_valid()) {
-				mesh = ma->get_mesh();
-				if (mesh.is_null()) {
+				if (ma->get_mesh().is_null()) {
 					LOG(WARN, "MeshAsset ", mesh_id, " valid but mesh is null, skipping");
 					fail = true;
 				}
@@ -78,43 +289,526 @@ void Terrain3DInstancer::_update_mmis(const Vector2i &p_region_loc, const int p_
 
 			/// Data seems good, apply it
 
-			// Update mesh in the Multimesh in case IDs or meshes changed.
-			mm->set_mesh(mesh);
-
-			// Assign MMs to MMIs, creating any missing MMIs
-			Vector3i mmi_key = Vector3i(region_loc.x, region_loc.y, mesh_id);
-			MultiMeshInstance3D *mmi;
-			if (!_mmis.has(mmi_key)) {
-				LOG(DEBUG, "No MMI found, creating new MultiMeshInstance3D, attaching to tree");
-				mmi = memnew(MultiMeshInstance3D);
-				mmi->set_as_top_level(true);
-				_terrain->get_mmi_parent()->add_child(mmi, true);
-				_mmis[mmi_key] = mmi;
-				LOG(DEBUG, _mmis);
+			// Remove instances of cells that no longer exist
+			for (int c = 0; c < cells_per_side * cells_per_side; c++) {
+				Vector2i cell = Vector2i(c % cells_per_side, c / cells_per_side);
+				if (!cell_dict.has(cell) && _cell_instances.has({ region_loc, cell, mesh_id })) {
+					_destroy_mmi_by_cell(region_loc, mesh_id, cell);
+				}
 			}
-			mmi = cast_to<MultiMeshInstance3D>(_mmis[mmi_key]);
-			mmi->set_multimesh(mm);
-			mmi->set_cast_shadows_setting(ma->get_cast_shadows());
-			if (mmi->is_inside_tree() && mmi->get_global_transform() != Transform3D()) {
-				LOG(WARN, "Terrain3D parent nodes have non-zero transform. Resetting instancer global_transform");
-				mmi->set_global_transform(Transform3D());
+			// Assign MMs to instances, creating any missing instances
+			Array cells = cell_dict.keys();
+			for (int c = 0; c < cells.size(); c++) {
+				_update_mmi_by_cell(region_loc, mesh_id, cells[c]);
 			}
 		}
 		LOG(DEBUG, "mm: ", mesh_dict);
 	}
-	LOG(DEBUG, "_mmis: ", _mmis);
+	LOG(DEBUG, "Cell instances: ", int(_cell_instances.size()));
+}
+
+// Assigns the MultiMesh of one cell to its RenderingServer instances, one per LOD, creating or freeing them as needed
+// LOD0 draws the stored MultiMesh. Other LODs draw a runtime copy of it w/ their own mesh.
+void Terrain3DInstancer::_update_mmi_by_cell(const Vector2i &p_region_loc, const int p_mesh_id, const Vector2i &p_cell) {
+	Ref<MultiMesh> mm = get_multimesh(p_region_loc, p_mesh_id, p_cell);
+	Ref<Terrain3DMeshAsset> ma = _terrain->get_assets()->get_mesh_asset(p_mesh_id);
+	if (mm.is_null() || ma.is_null() || ma->get_mesh().is_null()) {
+		return;
+	}
+	// Update mesh in the Multimesh in case IDs or meshes changed.
+	mm->set_mesh(ma->get_mesh());
+	_collision_dirty = true;
+
+	// A headless server keeps the MultiMesh data for collision and queries, but draws nothing
+	if (IS_HEADLESS) {
+		return;
+	}
+
+	CellInstances &ci = _cell_instances[{ p_region_loc, p_cell, p_mesh_id }];
+
+	// Free instances of LODs no longer used
+	uint32_t lod_count = ma->get_lod_count();
+	while (ci.instances.size() > lod_count) {
+		RS->free_rid(ci.instances[ci.instances.size() - 1]);
+		if (ci.multimeshes[ci.multimeshes.size() - 1].is_valid()) {
+			RS->free_rid(ci.multimeshes[ci.multimeshes.size() - 1]);
+		}
+		ci.instances.resize(ci.instances.size() - 1);
+		ci.multimeshes.resize(ci.multimeshes.size() - 1);
+	}
+
+	// Scenario is set by _update_instance_settings() if not in the tree yet
+	RID scenario = _terrain->is_inside_tree() ? _terrain->get_world_3d()->get_scenario() : RID();
+	bool visible = _terrain->is_visible_in_tree();
+	uint32_t layers = _terrain->get_render_layers() & ~(1u << (_terrain->get_mouse_layer() - 1));
+	for (uint32_t lod = 0; lod < lod_count; lod++) {
+		if (lod >= ci.instances.size()) {
+			LOG(DEBUG, "No instance found for LOD ", lod, ", creating new RenderingServer instance");
+			RID base = mm->get_rid();
+			RID lod_mm;
+			if (lod > 0) {
+				lod_mm = RS->multimesh_create();
+				base = lod_mm;
+			}
+			RID instance = RS->instance_create2(base, scenario);
+			RS->instance_set_visible(instance, visible);
+			RS->instance_set_layer_mask(instance, layers);
+			ci.instances.push_back(instance);
+			ci.multimeshes.push_back(lod_mm);
+		} else if (lod == 0) {
+			RS->instance_set_base(ci.instances[0], mm->get_rid());
+		}
+		if (lod > 0) {
+			Ref<Mesh> mesh = ma->get_mesh(lod);
+			RS->multimesh_set_mesh(ci.multimeshes[lod], mesh.is_valid() ? mesh->get_rid() : RID());
+			_copy_lod_multimesh(mm, ci.multimeshes[lod]);
+		}
+		Vector2 range = ma->get_lod_range(lod);
+		RS->instance_geometry_set_visibility_range(ci.instances[lod], range.x, range.y, 0.f, 0.f, RenderingServer::VISIBILITY_RANGE_FADE_DISABLED);
+		RS->instance_geometry_set_cast_shadows_setting(ci.instances[lod], RenderingServer::ShadowCastingSetting(ma->get_lod_cast_shadows(lod)));
+	}
+}
+
+// Refreshes the LOD copies of a cell after its instances were edited
+void Terrain3DInstancer::_update_lods(const Vector2i &p_region_loc, const int p_mesh_id, const Vector2i &p_cell) {
+	_collision_dirty = true;
+	CellInstances *ci = _cell_instances.getptr({ p_region_loc, p_cell, p_mesh_id });
+	if (ci == nullptr || ci->multimeshes.size() < 2) {
+		return;
+	}
+	Ref<MultiMesh> mm = get_multimesh(p_region_loc, p_mesh_id, p_cell);
+	if (mm.is_null()) {
+		return;
+	}
+	for (uint32_t lod = 1; lod < ci->multimeshes.size(); lod++) {
+		_copy_lod_multimesh(mm, ci->multimeshes[lod]);
+	}
+}
+
+// Copies the instances of a cell's LOD0 MultiMesh into the copy drawn by another LOD
+void Terrain3DInstancer::_copy_lod_multimesh(const Ref<MultiMesh> &p_src, const RID &p_dst) const {
+	int capacity = p_src->get_instance_count();
+	if (RS->multimesh_get_instance_count(p_dst) != capacity) {
+		RS->multimesh_allocate_data(p_dst, capacity, RenderingServer::MULTIMESH_TRANSFORM_3D, true);
+	}
+	RS->multimesh_set_buffer(p_dst, p_src->get_buffer());
+	RS->multimesh_set_visible_instances(p_dst, _get_instance_count(p_src));
+}
+
+void Terrain3DInstancer::_free_cell_instances(CellInstances &p_cell_instances) const {
+	for (const RID &rid : p_cell_instances.instances) {
+		RS->free_rid(rid);
+	}
+	for (const RID &rid : p_cell_instances.multimeshes) {
+		if (rid.is_valid()) {
+			RS->free_rid(rid);
+		}
+	}
+	p_cell_instances.instances.clear();
+	p_cell_instances.multimeshes.clear();
+}
+
+// Applies the visibility, scenario, and render layers of the terrain to all instances, and its space to collision
+void Terrain3DInstancer::_update_instance_settings() {
+	if (_terrain == nullptr || !_terrain->is_inside_tree()) {
+		return;
+	}
+	RID scenario = _terrain->get_world_3d()->get_scenario();
+	bool visible = _terrain->is_visible_in_tree();
+	uint32_t layers = _terrain->get_render_layers() & ~(1u << (_terrain->get_mouse_layer() - 1));
+	for (const KeyValue<CellKey, CellInstances> &E : _cell_instances) {
+		for (const RID &rid : E.value.instances) {
+			RS->instance_set_scenario(rid, scenario);
+			RS->instance_set_visible(rid, visible);
+			RS->instance_set_layer_mask(rid, layers);
+		}
+	}
+	RID space = _terrain->get_world_3d()->get_space();
+	for (const KeyValue<int64_t, CollisionBody> &E : _collision_bodies) {
+		PhysicsServer3D::get_singleton()->body_set_space(E.value.body, space);
+	}
+}
+
+// Gives collision to the instances of mesh assets w/ collision enabled, within their collision radius
+// of any target. Bodies of instances no longer in range return to the pool for reuse.
+// Runs only when a target has moved COLLISION_UPDATE_DISTANCE, or instances have changed.
+void Terrain3DInstancer::_update_collision() {
+	IS_DATA_INIT(VOID);
+	LocalVector<Vector3> positions;
+	for (uint32_t i = 0; i < _collision_targets.size(); i++) {
+		Node3D *target = cast_to<Node3D>(ObjectDB::get_instance(_collision_targets[i]));
+		if (target == nullptr) {
+			LOG(DEBUG, "Removing freed collision target");
+			_collision_targets.remove_at(i--);
+		} else if (target->is_inside_tree()) {
+			positions.push_back(target->get_global_position());
+		}
+	}
+	if (_collision_targets.is_empty() && _terrain->get_camera() != nullptr && _terrain->get_camera()->is_inside_tree()) {
+		positions.push_back(_terrain->get_camera()->get_global_position());
+	}
+	bool moved = _collision_dirty || positions.size() != _collision_positions.size();
+	for (uint32_t i = 0; i < positions.size() && !moved; i++) {
+		moved = positions[i].distance_to(_collision_positions[i]) > COLLISION_UPDATE_DISTANCE;
+	}
+	if (!moved) {
+		return;
+	}
+	_collision_positions = positions;
+	_collision_dirty = false;
+
+	PhysicsServer3D *ps = PhysicsServer3D::get_singleton();
+	RID space = _terrain->get_world_3d()->get_space();
+	int cells_per_side = _terrain->get_region_size() / CELL_SIZE;
+	for (KeyValue<int64_t, CollisionBody> &E : _collision_bodies) {
+		E.value.used = false;
+	}
+	Ref<Terrain3DAssets> assets = _terrain->get_assets();
+	for (int mesh_id = 0; mesh_id < assets->get_mesh_count(); mesh_id++) {
+		Ref<Terrain3DMeshAsset> ma = assets->get_mesh_asset(mesh_id);
+		if (ma.is_null() || !ma->get_collision_enabled()) {
+			continue;
+		}
+		Ref<Shape3D> shape = ma->get_collision_shape();
+		if (shape.is_null()) {
+			continue;
+		}
+		real_t radius = ma->get_collision_radius();
+		uint32_t mirrored = 0;
+		for (const Vector3 &position : positions) {
+			LocalVector<CellRef> cells;
+			Rect2 rect = Rect2(position.x - radius, position.z - radius, radius * 2.f, radius * 2.f);
+			_find_cells(rect, mesh_id, cells);
+			for (const CellRef &cell_ref : cells) {
+				int count = _get_instance_count(cell_ref.mm);
+				int region_index = Terrain3DData::get_region_map_index(cell_ref.region->get_location());
+				int cell_index = cell_ref.cell.y * cells_per_side + cell_ref.cell.x;
+				PackedRealArray buffer = cell_ref.mm->get_buffer();
+				const real_t *src = buffer.ptr();
+				for (int i = 0; i < count; i++) {
+					const real_t *b = src + i * MM_STRIDE;
+					Vector3 origin = Vector3(b[3], b[7], b[11]);
+					if (position.distance_squared_to(origin) > radius * radius) {
+						continue;
+					}
+					Transform3D xform = Transform3D(b[0], b[1], b[2], b[4], b[5], b[6], b[8], b[9], b[10], b[3], b[7], b[11]);
+					// Physics bodies can't be mirrored
+					if (xform.basis.determinant() < 0.f) {
+						mirrored++;
+						continue;
+					}
+					CollisionBody &cb = _collision_bodies[_make_handle(mesh_id, region_index, cell_index, i)];
+					if (!cb.body.is_valid()) {
+						if (_collision_pool.is_empty()) {
+							cb.body = ps->body_create();
+							ps->body_set_mode(cb.body, PhysicsServer3D::BODY_MODE_STATIC);
+							ps->body_attach_object_instance_id(cb.body, _terrain->get_instance_id());
+						} else {
+							cb.body = _collision_pool[_collision_pool.size() - 1];
+							_collision_pool.resize(_collision_pool.size() - 1);
+						}
+						ps->body_set_collision_layer(cb.body, _terrain->get_collision_layer());
+						ps->body_set_collision_mask(cb.body, _terrain->get_collision_mask());
+						ps->body_set_collision_priority(cb.body, _terrain->get_collision_priority());
+						ps->body_set_space(cb.body, space);
+						cb.shape = RID();
+					}
+					// Pooled bodies, and bodies whose shape was rebuilt by the mesh asset, get the current shape
+					if (cb.shape != shape->get_rid()) {
+						cb.shape = shape->get_rid();
+						ps->body_clear_shapes(cb.body);
+						ps->body_add_shape(cb.body, cb.shape);
+						cb.xform = Transform3D(Basis(), V3_MAX);
+					}
+					// Bodies can't be scaled, so the scale goes on the shape. Any shear is dropped
+					if (cb.xform != xform) {
+						cb.xform = xform;
+						ps->body_set_state(cb.body, PhysicsServer3D::BODY_STATE_TRANSFORM, Transform3D(xform.basis.orthonormalized(), xform.origin));
+						ps->body_set_shape_transform(cb.body, 0, Transform3D(Basis::from_scale(xform.basis.get_scale())));
+					}
+					cb.used = true;
+				}
+			}
+		}
+		if (mirrored > 0) {
+			LOG(WARN, "Skipping collision for ", mirrored, " mirrored instances of mesh ", mesh_id);
+		}
+	}
+
+	// Return bodies out of range to the pool
+	LocalVector<int64_t> unused;
+	for (const KeyValue<int64_t, CollisionBody> &E : _collision_bodies) {
+		if (!E.value.used) {
+			unused.push_back(E.key);
+		}
+	}
+	for (const int64_t handle : unused) {
+		RID body = _collision_bodies[handle].body;
+		ps->body_set_space(body, RID());
+		_collision_pool.push_back(body);
+		_collision_bodies.erase(handle);
+	}
+	LOG(DEBUG, "Instance collision bodies: ", int(_collision_bodies.size()), ", pooled: ", _collision_pool.size());
+}
+
+void Terrain3DInstancer::_destroy_collision() {
+	PhysicsServer3D *ps = PhysicsServer3D::get_singleton();
+	for (const KeyValue<int64_t, CollisionBody> &E : _collision_bodies) {
+		ps->free_rid(E.value.body);
+	}
+	for (const RID &body : _collision_pool) {
+		ps->free_rid(body);
+	}
+	_collision_bodies.clear();
+	_collision_pool.clear();
+	_collision_positions.clear();
+	_collision_dirty = true;
 }
 
 void Terrain3DInstancer::_destroy_mmi_by_location(const Vector2i &p_region_loc, const int p_mesh_id) {
-	Vector3i mmi_key = Vector3i(p_region_loc.x, p_region_loc.y, p_mesh_id);
-	LOG(DEBUG, "Deleting MMI at: ", p_region_loc, " mesh_id: ", p_mesh_id);
-	MultiMeshInstance3D *mmi = cast_to<MultiMeshInstance3D>(_mmis[mmi_key]);
-	bool result = _mmis.erase(mmi_key);
-	LOG(DEBUG, "Removing mmi from dictionary: ", mmi, ", success: ", result);
-	result = remove_from_tree(mmi);
-	LOG(DEBUG, "Removing from tree, success: ", result);
-	result = memdelete_safely(mmi);
-	LOG(DEBUG, "Deleting MMI, success: ", result);
+	LOG(DEBUG, "Freeing instances at: ", p_region_loc, " mesh_id: ", p_mesh_id);
+	int cells_per_side = _terrain->get_region_size() / CELL_SIZE;
+	for (int c = 0; c < cells_per_side * cells_per_side; c++) {
+		_destroy_mmi_by_cell(p_region_loc, p_mesh_id, Vector2i(c % cells_per_side, c / cells_per_side));
+	}
+}
+
+void Terrain3DInstancer::_destroy_mmi_by_cell(const Vector2i &p_region_loc, const int p_mesh_id, const Vector2i &p_cell) {
+	CellKey key = { p_region_loc, p_cell, p_mesh_id };
+	_collision_dirty = true;
+	CellInstances *ci = _cell_instances.getptr(key);
+	if (ci == nullptr) {
+		return;
+	}
+	LOG(DEBUG_CONT, "Freeing ", ci->instances.size(), " LOD instances at: ", p_region_loc, " mesh_id: ", p_mesh_id, " cell: ", p_cell);
+	_free_cell_instances(*ci);
+	_cell_instances.erase(key);
+}
+
+// Splits a region MultiMesh saved before cells were introduced into cells
+void Terrain3DInstancer::_upgrade_multimesh(const Ref<Terrain3DRegion> &p_region, const int p_mesh_id) {
+	Dictionary mesh_dict = p_region->get_multimeshes();
+	Ref<MultiMesh> mm = mesh_dict[p_mesh_id];
+	mesh_dict.erase(p_mesh_id);
+	int count = _get_instance_count(mm);
+	LOG(INFO, "Splitting ", count, " instances of mesh ", p_mesh_id, " in region ", p_region->get_location(), " into cells");
+	LocalVector<Transform3D> xforms;
+	LocalVector<Color> colors;
+	xforms.reserve(count);
+	colors.reserve(count);
+	for (int i = 0; i < count; i++) {
+		xforms.push_back(mm->get_instance_transform(i));
+		colors.push_back(mm->is_using_colors() ? mm->get_instance_color(i) : COLOR_WHITE);
+	}
+	_append_region(p_region, p_mesh_id, xforms.ptr(), colors.ptr(), count, false);
+	p_region->set_modified(true);
+}
+
+// Sorts instances of one region into cells and appends them to each cell
+// Clear replaces all existing instances, removing cells without new instances
+void Terrain3DInstancer::_append_region(const Ref<Terrain3DRegion> &p_region, const int p_mesh_id,
+		const Transform3D *p_xforms, const Color *p_colors, const uint32_t p_count, const bool p_clear) {
+	int region_size = p_region->get_region_size();
+	int cells_per_side = region_size / CELL_SIZE;
+	uint32_t count = p_count;
+
+	// Counting sort by cell index
+	LocalVector<uint32_t> cell_indices;
+	cell_indices.resize(count);
+	LocalVector<uint32_t> offsets;
+	offsets.resize(cells_per_side * cells_per_side + 1);
+	memset(offsets.ptr(), 0, offsets.size() * sizeof(uint32_t));
+	for (uint32_t i = 0; i < count; i++) {
+		Vector2i cell = _get_cell(p_xforms[i].origin, region_size);
+		cell_indices[i] = cell.y * cells_per_side + cell.x;
+		offsets[cell_indices[i] + 1]++;
+	}
+	for (uint32_t c = 1; c < offsets.size(); c++) {
+		offsets[c] += offsets[c - 1];
+	}
+	LocalVector<Transform3D> xforms;
+	LocalVector<Color> colors;
+	xforms.resize(count);
+	colors.resize(count);
+	LocalVector<uint32_t> next = offsets;
+	for (uint32_t i = 0; i < count; i++) {
+		uint32_t dst = next[cell_indices[i]]++;
+		xforms[dst] = p_xforms[i];
+		colors[dst] = p_colors[i];
+	}
+
+	// Back up before writing, as multimeshes are edited in place
+	_backup_region(p_region);
+	if (p_clear) {
+		Dictionary mesh_dict = p_region->get_multimeshes();
+		Dictionary cell_dict = mesh_dict.get(p_mesh_id, Dictionary());
+		Array cells = cell_dict.keys();
+		for (int i = 0; i < cells.size(); i++) {
+			Vector2i cell = cells[i];
+			uint32_t c = cell.y * cells_per_side + cell.x;
+			if (c >= offsets.size() - 1 || offsets[c + 1] == offsets[c]) {
+				_append_cell(p_region, p_mesh_id, cell, nullptr, nullptr, 0, true);
+			}
+		}
+	}
+	for (uint32_t c = 0; c < offsets.size() - 1; c++) {
+		uint32_t cell_count = offsets[c + 1] - offsets[c];
+		if (cell_count > 0) {
+			Vector2i cell = Vector2i(c % cells_per_side, c / cells_per_side);
+			_append_cell(p_region, p_mesh_id, cell, &xforms[offsets[c]], &colors[offsets[c]], cell_count, p_clear);
+		}
+	}
+}
+
+// Appends instances to the MultiMesh of one cell, creating it if needed. Clear replaces existing instances.
+// Multimeshes keep spare capacity beyond visible_instance_count, so appending only writes the new
+// instances. The buffer is copied only when the capacity grows, which doubles it each time.
+// The caller backs up the region.
+void Terrain3DInstancer::_append_cell(const Ref<Terrain3DRegion> &p_region, const int p_mesh_id, const Vector2i &p_cell,
+		const Transform3D *p_xforms, const Color *p_colors, const int p_count, const bool p_clear) {
+	Vector2i region_loc = p_region->get_location();
+	Dictionary mesh_dict = p_region->get_multimeshes();
+	if (!mesh_dict.has(p_mesh_id)) {
+		mesh_dict[p_mesh_id] = Dictionary();
+	}
+	Dictionary cell_dict = mesh_dict[p_mesh_id];
+	Ref<MultiMesh> mm = cell_dict.get(p_cell, Ref<MultiMesh>());
+	int old_count = p_clear ? 0 : _get_instance_count(mm);
+	int count = p_count;
+	if (old_count + count > MAX_CELL_INSTANCES) {
+		count = MAX(0, MAX_CELL_INSTANCES - old_count);
+		LOG(WARN, "Cell ", p_cell, " in region ", region_loc, " is limited to ", MAX_CELL_INSTANCES,
+				" instances of mesh ", p_mesh_id, ". Dropping ", p_count - count);
+	}
+
+	// Erase empties if no transforms in both the old and new data
+	int new_count = old_count + count;
+	if (new_count == 0) {
+		cell_dict.erase(p_cell);
+		if (cell_dict.is_empty()) {
+			mesh_dict.erase(p_mesh_id);
+		}
+		_destroy_mmi_by_cell(region_loc, p_mesh_id, p_cell);
+		return;
+	}
+
+	bool is_new = mm.is_null();
+	if (is_new) {
+		mm.instantiate();
+		mm->set_transform_format(MultiMesh::TRANSFORM_3D);
+		mm->set_use_colors(true);
+	}
+
+	// Rebuild the buffer when growing or clearing, keeping existing instances, and write the new ones into it
+	int capacity = mm->get_instance_count();
+	if (new_count > capacity || p_clear) {
+		PackedRealArray buffer;
+		if (old_count > 0) {
+			buffer = mm->get_buffer();
+		}
+		if (new_count > capacity) {
+			capacity = p_clear ? new_count : MAX(new_count, capacity * 2);
+			LOG(DEBUG_CONT, "Growing multimesh capacity to ", capacity, " in region: ", region_loc, ", mesh_id: ", p_mesh_id, ", cell: ", p_cell);
+		}
+		buffer.resize(capacity * MM_STRIDE);
+		real_t *dst = buffer.ptrw();
+		for (int i = 0; i < count; i++) {
+			_write_instance(dst + (i + old_count) * MM_STRIDE, p_xforms[i], p_colors[i]);
+		}
+		_fill_spare_instances(dst, new_count, capacity);
+		if (mm->get_instance_count() != capacity) {
+			mm->set_instance_count(capacity);
+		}
+		mm->set_buffer(buffer);
+	} else {
+		for (int i = 0; i < count; i++) {
+			mm->set_instance_transform(i + old_count, p_xforms[i]);
+			mm->set_instance_color(i + old_count, p_colors[i]);
+		}
+	}
+	mm->set_visible_instance_count(new_count);
+
+	LOG(DEBUG_CONT, "Setting multimesh in region: ", region_loc, ", mesh_id: ", p_mesh_id, ", cell: ", p_cell, " instance count: ", new_count, " mm: ", mm);
+	if (is_new) {
+		cell_dict[p_cell] = mm;
+		_update_mmi_by_cell(region_loc, p_mesh_id, p_cell);
+	} else {
+		_update_lods(region_loc, p_mesh_id, p_cell);
+	}
+}
+
+// Stores the first p_count instances of p_buffer, the cell's buffer after removing or moving instances,
+// as the cell's MultiMesh. Backs up the region first, and erases the cell if none remain.
+void Terrain3DInstancer::_compact_cell(const Ref<Terrain3DRegion> &p_region, const int p_mesh_id, const Vector2i &p_cell,
+		PackedRealArray &p_buffer, const int p_count) {
+	_backup_region(p_region);
+	if (p_count == 0) {
+		LOG(DEBUG, "Removed all instances, erasing multimesh in cell ", p_cell);
+		_append_cell(p_region, p_mesh_id, p_cell, nullptr, nullptr, 0, true);
+		return;
+	}
+	Vector2i region_loc = p_region->get_location();
+	Ref<MultiMesh> mm = get_multimesh(region_loc, p_mesh_id, p_cell);
+	_fill_spare_instances(p_buffer.ptrw(), p_count, mm->get_instance_count());
+	mm->set_buffer(p_buffer);
+	mm->set_visible_instance_count(p_count);
+	_update_lods(region_loc, p_mesh_id, p_cell);
+}
+
+// Adds the mesh asset height offset, then sorts instances by region and appends them to the cells of each
+// Uses a counting sort over the region map, so no per-instance Variants or Dictionaries are created
+void Terrain3DInstancer::_add_transforms(const int p_mesh_id, LocalVector<Transform3D> &p_xforms, const LocalVector<Color> &p_colors) {
+	Terrain3DData *data = _terrain->get_data();
+	Ref<Terrain3DMeshAsset> mesh_asset = _terrain->get_assets()->get_mesh_asset(p_mesh_id);
+	real_t height_offset = mesh_asset->get_height_offset();
+	uint32_t count = p_xforms.size();
+	// The last bucket collects instances outside of the region map
+	const int map_size = Terrain3DData::REGION_MAP_SIZE * Terrain3DData::REGION_MAP_SIZE;
+
+	LocalVector<uint32_t> region_indices;
+	region_indices.resize(count);
+	LocalVector<uint32_t> offsets;
+	offsets.resize(map_size + 2);
+	memset(offsets.ptr(), 0, offsets.size() * sizeof(uint32_t));
+	for (uint32_t i = 0; i < count; i++) {
+		Transform3D &trns = p_xforms[i];
+		trns.origin += trns.basis.get_column(1) * height_offset; // Offset along UP axis
+		int index = Terrain3DData::get_region_map_index(data->get_region_location(trns.origin));
+		region_indices[i] = (index < 0) ? map_size : index;
+		offsets[region_indices[i] + 1]++;
+	}
+	for (uint32_t r = 1; r < offsets.size(); r++) {
+		offsets[r] += offsets[r - 1];
+	}
+	LocalVector<Transform3D> xforms;
+	LocalVector<Color> colors;
+	xforms.resize(count);
+	colors.resize(count);
+	LocalVector<uint32_t> next = offsets;
+	for (uint32_t i = 0; i < count; i++) {
+		uint32_t dst = next[region_indices[i]]++;
+		xforms[dst] = p_xforms[i];
+		colors[dst] = (i < p_colors.size()) ? p_colors[i] : COLOR_WHITE;
+	}
+
+	uint32_t dropped = offsets[map_size + 1] - offsets[map_size];
+	for (int r = 0; r < map_size; r++) {
+		uint32_t region_count = offsets[r + 1] - offsets[r];
+		if (region_count == 0) {
+			continue;
+		}
+		Vector2i region_loc = Vector2i(r % Terrain3DData::REGION_MAP_SIZE, r / Terrain3DData::REGION_MAP_SIZE) - Terrain3DData::REGION_MAP_VSIZE / 2;
+		Ref<Terrain3DRegion> region = data->get_region(region_loc);
+		if (region.is_null()) {
+			dropped += region_count;
+			continue;
+		}
+		LOG(DEBUG, "Adding ", region_count, " transforms to region location: ", region_loc);
+		_append_region(region, p_mesh_id, &xforms[offsets[r]], &colors[offsets[r]], region_count, false);
+	}
+	if (dropped > 0) {
+		LOG(WARN, "Skipped ", dropped, " instances outside of regions");
+	}
 }
 
 void Terrain3DInstancer::_backup_regionl(const Vector2i &p_region_loc) {
@@ -125,13 +819,62 @@ void Terrain3DInstancer::_backup_regionl(const Vector2i &p_region_loc) {
 }
 
 void Terrain3DInstancer::_backup_region(const Ref<Terrain3DRegion> &p_region) {
-	if (_terrain->get_editor() != nullptr) {
+	if (_terrain->get_editor() != nullptr && _terrain->get_editor()->is_operating()) {
 		_terrain->get_editor()->backup_region(p_region);
 	} else {
 		p_region->set_modified(true);
 	}
 }
 
+// Finds the instances w/ origins in an area, and within a radius of its center if positive
+// Only the cells under the area are read, each in one buffer copy
+Dictionary Terrain3DInstancer::_query_instances(const AABB &p_area, const real_t p_radius, const int64_t p_mesh_mask) const {
+	PackedInt64Array handles;
+	PackedFloat32Array xforms;
+	Dictionary result;
+	result["handles"] = handles;
+	result["transforms"] = xforms;
+	IS_DATA_INIT_MESG("Instancer isn't initialized.", result);
+
+	Rect2 rect = Rect2(p_area.position.x, p_area.position.z, p_area.size.x, p_area.size.z);
+	LocalVector<CellRef> cells;
+	_find_cells(rect, -1, cells);
+	Vector3 center = p_area.get_center();
+	real_t radius_sq = p_radius * p_radius;
+	int cells_per_side = _terrain->get_region_size() / CELL_SIZE;
+	for (const CellRef &cell_ref : cells) {
+		// Mesh ids beyond the mask bits are only included w/ all bits set
+		if (p_mesh_mask != -1 && (cell_ref.mesh_id >= 64 || !(p_mesh_mask & (int64_t(1) << cell_ref.mesh_id)))) {
+			continue;
+		}
+		int count = _get_instance_count(cell_ref.mm);
+		if (count == 0) {
+			continue;
+		}
+		int region_index = Terrain3DData::get_region_map_index(cell_ref.region->get_location());
+		int cell_index = cell_ref.cell.y * cells_per_side + cell_ref.cell.x;
+		PackedRealArray buffer = cell_ref.mm->get_buffer();
+		const real_t *src = buffer.ptr();
+		for (int i = 0; i < count; i++) {
+			const real_t *b = src + i * MM_STRIDE;
+			Vector3 origin = Vector3(b[3], b[7], b[11]);
+			if (!p_area.has_point(origin) || (p_radius > 0.f && center.distance_squared_to(origin) > radius_sq)) {
+				continue;
+			}
+			handles.push_back(_make_handle(cell_ref.mesh_id, region_index, cell_index, i));
+			int64_t offset = xforms.size();
+			xforms.resize(offset + 12);
+			float *dst = xforms.ptrw() + offset;
+			for (int k = 0; k < 12; k++) {
+				dst[k] = b[k];
+			}
+		}
+	}
+	result["handles"] = handles;
+	result["transforms"] = xforms;
+	return result;
+}
+
 ///////////////////////////
 // Public Functions
 ///////////////////////////
@@ -142,17 +885,32 @@ void Terrain3DInstancer::initialize(Terrain3D *p_terrain) {
 	}
 	IS_DATA_INIT_MESG("Terrain or storage not ready yet", VOID);
 	LOG(INFO, "Initializing Instancer");
+	// MultiMeshes keep their data in the RenderingServer. Headless, collision, queries, and saving
+	// read it back from the dummy renderer, which must return it
+	if (IS_HEADLESS) {
+		Ref<MultiMesh> mm;
+		mm.instantiate();
+		mm->set_transform_format(MultiMesh::TRANSFORM_3D);
+		mm->set_use_colors(true);
+		mm->set_instance_count(1);
+		PackedRealArray buffer;
+		buffer.resize(MM_STRIDE);
+		_write_instance(buffer.ptrw(), Transform3D(), COLOR_WHITE);
+		mm->set_buffer(buffer);
+		if (mm->get_buffer().size() != MM_STRIDE) {
+			LOG(ERROR, "The headless renderer of this Godot version doesn't keep MultiMesh data. Instance collision, queries, and saving won't work");
+		}
+	}
 	_update_mmis();
 }
 
 void Terrain3DInstancer::destroy() {
-	IS_DATA_INIT(VOID);
-	LOG(INFO, "Destroying all MMIs");
-	while (_mmis.size() > 0) {
-		Vector3i key = _mmis.keys()[0];
-		_destroy_mmi_by_location(Vector2i(key.x, key.y), key.z);
+	LOG(INFO, "Freeing all instances");
+	_destroy_collision();
+	for (KeyValue<CellKey, CellInstances> &E : _cell_instances) {
+		_free_cell_instances(E.value);
 	}
-	_mmis.clear();
+	_cell_instances.clear();
 }
 
 void Terrain3DInstancer::clear_by_mesh(const int p_mesh_id) {
@@ -191,10 +949,9 @@ void Terrain3DInstancer::add_instances(const Vector3 &p_global_position, const D
 	real_t brush_size = CLAMP(real_t(p_params.get("size", 10.f)), 2.f, 4096.f); // Meters
 	real_t radius = brush_size * .4f; // Ring1's inner radius
 	real_t strength = CLAMP(real_t(p_params.get("strength", .1f)), .01f, 100.f); // (premul) 1-10k%
-	real_t fixed_scale = CLAMP(real_t(p_params.get("fixed_scale", 100.f)) * .01f, .01f, 100.f); // 1-10k%
-	real_t random_scale = CLAMP(real_t(p_params.get("random_scale", 0.f)) * .01f, 0.f, 10.f); // +/- 1000%
+	InstanceParams params = _get_instance_params(p_params);
 	real_t density = CLAMP(.1f * brush_size * strength * mesh_asset->get_density() /
-					MAX(0.01f, fixed_scale + .5f * random_scale),
+					MAX(0.01f, params.fixed_scale + .5f * params.random_scale),
 			.001f, 1000.f);
 
 	// Density based on strength, mesh AABB and input scale determines how many to place, even fractional
@@ -204,27 +961,13 @@ void Terrain3DInstancer::add_instances(const Vector3 &p_global_position, const D
 	}
 	LOG(DEBUG_CONT, "Adding ", count, " instances at ", p_global_position);
 
-	real_t fixed_spin = CLAMP(real_t(p_params.get("fixed_spin", 0.f)), .0f, 360.f); // degrees
-	real_t random_spin = CLAMP(real_t(p_params.get("random_spin", 360.f)), 0.f, 360.f); // degrees
-	real_t fixed_angle = CLAMP(real_t(p_params.get("fixed_angle", 0.f)), -180.f, 180.f); // degrees
-	real_t random_angle = CLAMP(real_t(p_params.get("random_angle", 10.f)), 0.f, 180.f); // degrees
-	bool align_to_normal = bool(p_params.get("align_to_normal", false));
-
-	real_t height_offset = CLAMP(real_t(p_params.get("height_offset", 0.f)), -100.0f, 100.f); // meters
-	real_t random_height = CLAMP(real_t(p_params.get("random_height", 0.f)), 0.f, 100.f); // meters
-
-	Color vertex_color = Color(p_params.get("vertex_color", COLOR_WHITE));
-	real_t random_hue = CLAMP(real_t(p_params.get("random_hue", 0.f)) / 360.f, 0.f, 1.f); // degrees -> 0-1
-	real_t random_darken = CLAMP(real_t(p_params.get("random_darken", 0.f)) * .01f, 0.f, 1.f); // 0-100%
-
+	uint32_t state = UtilityFunctions::randi();
 	TypedArray<Transform3D> xforms;
 	TypedArray<Color> colors;
 	for (int i = 0; i < count; i++) {
-		Transform3D t;
-
 		// Get random XZ position and height in a circle
-		real_t r_radius = radius * sqrt(UtilityFunctions::randf());
-		real_t r_theta = UtilityFunctions::randf() * Math_TAU;
+		real_t r_radius = radius * sqrt(rand_float(state));
+		real_t r_theta = rand_float(state) * Math_TAU;
 		Vector3 rand_vec = Vector3(r_radius * cos(r_theta), 0.f, r_radius * sin(r_theta));
 		Vector3 position = p_global_position + rand_vec;
 		// Get height, but skip holes
@@ -234,43 +977,14 @@ void Terrain3DInstancer::add_instances(const Vector3 &p_global_position, const D
 		} else {
 			position.y = height;
 		}
-
-		// Orientation
 		Vector3 normal = Vector3(0.f, 1.f, 0.f);
-		if (align_to_normal) {
+		if (params.align_to_normal) {
 			normal = _terrain->get_data()->get_normal(position);
-			if (std::isnan(normal.x)) {
-				normal = Vector3(0.f, 1.f, 0.f);
-			} else {
-				normal = normal.normalized();
-				Vector3 z_axis = Vector3(0.f, 0.f, 1.f);
-				Vector3 x_axis = -z_axis.cross(normal);
-				t.basis = Basis(x_axis, normal, z_axis).orthonormalized();
-			}
 		}
-		real_t spin = (fixed_spin + random_spin * UtilityFunctions::randf()) * Math_PI / 180.f;
-		if (abs(spin) > 0.001f) {
-			t.basis = t.basis.rotated(normal, spin);
-		}
-		real_t angle = (fixed_angle + random_angle * (2.f * UtilityFunctions::randf() - 1.f)) * Math_PI / 180.f;
-		if (abs(angle) > 0.001f) {
-			t.basis = t.basis.rotated(t.basis.get_column(0), angle); // Rotate pitch, X-axis
-		}
-
-		// Scale
-		real_t t_scale = CLAMP(fixed_scale + random_scale * (2.f * UtilityFunctions::randf() - 1.f), 0.01f, 10.f);
-		t = t.scaled(Vector3(t_scale, t_scale, t_scale));
-
-		// Position. mesh_asset height offset added in add_transforms
-		real_t offset = height_offset + random_height * (2.f * UtilityFunctions::randf() - 1.f);
-		position += t.basis.get_column(1) * offset; // Offset along UP axis
-		t = t.translated(position);
-
-		// Color
-		Color col = vertex_color;
-		col.set_v(CLAMP(col.get_v() - random_darken * UtilityFunctions::randf(), 0.f, 1.f));
-		col.set_h(fmod(col.get_h() + random_hue * (2.f * UtilityFunctions::randf() - 1.f), 1.f));
 
+		Transform3D t;
+		Color col;
+		_randomize_instance(params, position, normal, state, t, col);
 		xforms.push_back(t);
 		colors.push_back(col);
 	}
@@ -306,44 +1020,49 @@ void Terrain3DInstancer::remove_instances(const Vector3 &p_global_position, cons
 		return;
 	}
 
-	Vector2i region_loc = _terrain->get_data()->get_region_location(p_global_position);
-
-	LOG(DEBUG_CONT, "Removing ", count, " instances from ", p_global_position);
-	Ref<MultiMesh> multimesh = get_multimesh(region_loc, mesh_id);
-	if (multimesh.is_null()) {
+	// Review only the cells under the brush, which may span regions
+	Vector2 mouse2d = Vector2(p_global_position.x, p_global_position.z);
+	Rect2 brush_rect = Rect2(mouse2d - Vector2(radius, radius), Vector2(radius, radius) * 2.f);
+	LocalVector<CellRef> cells;
+	_find_cells(brush_rect, mesh_id, cells);
+	if (cells.is_empty()) {
 		LOG(DEBUG_CONT, "Multimesh is already null. doing nothing");
 		return;
 	}
 
-	TypedArray<Transform3D> xforms;
-	TypedArray<Color> colors;
-	for (int i = 0; i < multimesh->get_instance_count(); i++) {
-		Transform3D t = multimesh->get_instance_transform(i);
-		// If quota not yet met and instance within a cylinder radius, remove it
-		Vector2 origin2d = Vector2(t.origin.x, t.origin.z);
-		Vector2 mouse2d = Vector2(p_global_position.x, p_global_position.z);
-		if (count > 0 && (origin2d - mouse2d).length() < radius) {
-			count--;
-			continue;
-		} else {
-			xforms.push_back(t);
-			colors.push_back(multimesh->get_instance_color(i));
+	LOG(DEBUG_CONT, "Removing ", count, " instances from ", p_global_position, " in ", cells.size(), " cells");
+	for (uint32_t c = 0; c < cells.size() && count > 0; c++) {
+		const CellRef &cell_ref = cells[c];
+		Ref<MultiMesh> mm = cell_ref.mm;
+		// Compact the remaining instances in place
+		int instance_count = _get_instance_count(mm);
+		PackedRealArray buffer = mm->get_buffer();
+		real_t *b = buffer.ptrw();
+		int write = 0;
+		for (int i = 0; i < instance_count; i++) {
+			// If quota not yet met and instance within a cylinder radius, remove it
+			Vector2 origin2d = Vector2(b[i * MM_STRIDE + 3], b[i * MM_STRIDE + 11]);
+			if (count > 0 && (origin2d - mouse2d).length() < radius) {
+				count--;
+				continue;
+			}
+			if (write != i) {
+				memcpy(b + write * MM_STRIDE, b + i * MM_STRIDE, MM_STRIDE * sizeof(real_t));
+			}
+			write++;
+		}
+		if (write < instance_count) {
+			_compact_cell(cell_ref.region, mesh_id, cell_ref.cell, buffer, write);
 		}
-	}
-
-	if (xforms.size() == 0) {
-		LOG(DEBUG, "Removed all instances, erasing multimesh in region");
-		clear_by_location(region_loc, mesh_id);
-	} else {
-		append_multimesh(region_loc, mesh_id, xforms, colors, true);
 	}
 }
 
 void Terrain3DInstancer::add_multimesh(const int p_mesh_id, const Ref<MultiMesh> &p_multimesh, const Transform3D &p_xform) {
-	LOG(INFO, "Extracting ", p_multimesh->get_instance_count(), " transforms from multimesh");
+	int count = _get_instance_count(p_multimesh);
+	LOG(INFO, "Extracting ", count, " transforms from multimesh");
 	TypedArray<Transform3D> xforms;
 	TypedArray<Color> colors;
-	for (int i = 0; i < p_multimesh->get_instance_count(); i++) {
+	for (int i = 0; i < count; i++) {
 		xforms.push_back(p_xform * p_multimesh->get_instance_transform(i));
 		Color c = COLOR_WHITE;
 		if (p_multimesh->is_using_colors()) {
@@ -364,99 +1083,81 @@ void Terrain3DInstancer::add_transforms(const int p_mesh_id, const TypedArray<Tr
 		return;
 	}
 
-	Dictionary xforms_dict;
-	Dictionary colors_dict;
-	Ref<Terrain3DMeshAsset> mesh_asset = _terrain->get_assets()->get_mesh_asset(p_mesh_id);
-
-	// Separate incoming transforms/colors into Dictionary { region_loc => Array[Transform3D] }
 	LOG(INFO, "Separating ", p_xforms.size(), " transforms and ", p_colors.size(), " colors into regions");
+	LocalVector<Transform3D> xforms;
+	LocalVector<Color> colors;
+	xforms.resize(p_xforms.size());
+	colors.resize(p_colors.size());
 	for (int i = 0; i < p_xforms.size(); i++) {
-		// Get adjusted xform/color
-		Transform3D trns = p_xforms[i];
-		trns.origin += trns.basis.get_column(1) * mesh_asset->get_height_offset(); // Offset along UP axis
-		Color col = COLOR_WHITE;
-		if (p_colors.size() > i) {
-			col = p_colors[i];
-		}
-
-		// Store by region offset
-		Vector2i region_loc = _terrain->get_data()->get_region_location(trns.origin);
-		if (!xforms_dict.has(region_loc)) {
-			xforms_dict[region_loc] = TypedArray<Transform3D>();
-			colors_dict[region_loc] = TypedArray<Color>();
-		}
-		TypedArray<Transform3D> xforms = xforms_dict[region_loc];
-		TypedArray<Color> colors = colors_dict[region_loc];
-		xforms.push_back(trns);
-		colors.push_back(col);
+		xforms[i] = p_xforms[i];
+	}
+	for (int i = 0; i < p_colors.size(); i++) {
+		colors[i] = p_colors[i];
 	}
+	_add_transforms(p_mesh_id, xforms, colors);
+}
 
-	// Merge incoming transforms with existing transforms
-	Array region_locations = xforms_dict.keys();
-	for (int i = 0; i < region_locations.size(); i++) {
-		Vector2i region_loc = region_locations[i];
-		TypedArray<Transform3D> xforms = xforms_dict[region_loc];
-		TypedArray<Color> colors = colors_dict[region_loc];
-		LOG(DEBUG, "Adding ", xforms.size(), " transforms to region location: ", region_loc);
-		append_multimesh(region_loc, p_mesh_id, xforms, colors);
+// Adds instances from packed arrays, w/o creating a Variant per instance. Transforms are 12 floats each, laid out
+// as in a MultiMesh TRANSFORM_3D buffer: each of the three basis rows followed by one origin component.
+void Terrain3DInstancer::add_instances_buffer(const int p_mesh_id, const PackedFloat32Array &p_xforms, const PackedColorArray &p_colors) {
+	IS_DATA_INIT_MESG("Instancer isn't initialized.", VOID);
+	if (p_xforms.size() == 0) {
+		return;
+	}
+	if (p_mesh_id < 0 || p_mesh_id >= _terrain->get_assets()->get_mesh_count()) {
+		LOG(ERROR, "Mesh ID out of range: ", p_mesh_id, ", valid: 0 to ", _terrain->get_assets()->get_mesh_count() - 1);
+		return;
+	}
+	if (p_xforms.size() % 12 != 0) {
+		LOG(ERROR, "Transform buffer size ", p_xforms.size(), " is not a multiple of 12 floats");
+		return;
+	}
+	uint32_t count = p_xforms.size() / 12;
+	if (p_colors.size() > 0 && uint32_t(p_colors.size()) != count) {
+		LOG(ERROR, "Color count ", p_colors.size(), " doesn't match transform count ", count);
+		return;
+	}
+	LOG(INFO, "Adding ", count, " instances of mesh ", p_mesh_id, " from buffer");
+	LocalVector<Transform3D> xforms;
+	LocalVector<Color> colors;
+	xforms.resize(count);
+	colors.resize(p_colors.size());
+	const float *src = p_xforms.ptr();
+	for (uint32_t i = 0; i < count; i++) {
+		const float *b = src + i * 12;
+		xforms[i].basis.set(b[0], b[1], b[2], b[4], b[5], b[6], b[8], b[9], b[10]);
+		xforms[i].origin = Vector3(b[3], b[7], b[11]);
 	}
+	if (p_colors.size() > 0) {
+		memcpy(colors.ptr(), p_colors.ptr(), count * sizeof(Color));
+	}
+	_add_transforms(p_mesh_id, xforms, colors);
 }
 
-// Appends new transforms to existing multimeshes
+// Appends new transforms to existing multimeshes, sorted into cells. Clear replaces the old instances.
 void Terrain3DInstancer::append_multimesh(const Vector2i &p_region_loc, const int p_mesh_id,
 		const TypedArray<Transform3D> &p_xforms, const TypedArray<Color> &p_colors, const bool p_clear) {
 	IS_DATA_INIT(VOID);
-
-	// Collect old data
-	TypedArray<Transform3D> old_xforms;
-	TypedArray<Color> old_colors;
-	if (!p_clear) {
-		Ref<MultiMesh> multimesh = get_multimesh(p_region_loc, p_mesh_id);
-		if (multimesh.is_valid()) {
-			uint32_t old_count = multimesh->get_instance_count();
-			LOG(DEBUG_CONT, "Merging w/ old instances: ", old_count, ": ", multimesh);
-			for (int i = 0; i < old_count; i++) {
-				old_xforms.push_back(multimesh->get_instance_transform(i));
-				old_colors.push_back(multimesh->get_instance_color(i));
-			}
+	if (p_xforms.size() == 0) {
+		if (p_clear) {
+			clear_by_location(p_region_loc, p_mesh_id);
 		}
-	}
-
-	// Erase empties if no transforms in both the old and new data
-	if (old_xforms.size() == 0 && p_xforms.size() == 0) {
-		clear_by_location(p_region_loc, p_mesh_id);
 		return;
 	}
-
-	// Create a new Multimesh
-	Ref<MultiMesh> mm;
-	mm.instantiate();
-	mm->set_transform_format(MultiMesh::TRANSFORM_3D);
-	mm->set_use_colors(true);
-	int old_count = old_xforms.size();
-	mm->set_instance_count(old_count + p_xforms.size());
-	Ref<Terrain3DMeshAsset> mesh_asset = _terrain->get_assets()->get_mesh_asset(p_mesh_id);
-	Ref<Mesh> mesh = mesh_asset->get_mesh();
-	mm->set_mesh(mesh);
-	for (int i = 0; i < old_count; i++) {
-		mm->set_instance_transform(i, old_xforms[i]);
-		mm->set_instance_color(i, old_colors[i]);
-	}
-	for (int i = 0; i < p_xforms.size(); i++) {
-		mm->set_instance_transform(i + old_count, p_xforms[i]);
-		mm->set_instance_color(i + old_count, p_colors[i]);
-	}
-
-	LOG(DEBUG_CONT, "Setting multimesh in region: ", p_region_loc, ", mesh_id: ", p_mesh_id, " instance count: ", mm->get_instance_count(), " mm: ", mm);
 	Ref<Terrain3DRegion> region = _terrain->get_data()->get_region(p_region_loc);
 	if (region.is_null()) {
 		LOG(WARN, "No region found at: ", p_region_loc);
 		return;
 	}
-	_backup_region(region);
-	Dictionary mesh_dict = region->get_multimeshes();
-	mesh_dict[p_mesh_id] = mm;
-	_update_mmis(p_region_loc, p_mesh_id);
+	LocalVector<Transform3D> xforms;
+	LocalVector<Color> colors;
+	xforms.resize(p_xforms.size());
+	colors.resize(p_xforms.size());
+	for (int i = 0; i < p_xforms.size(); i++) {
+		xforms[i] = p_xforms[i];
+		colors[i] = (i < p_colors.size()) ? Color(p_colors[i]) : COLOR_WHITE;
+	}
+	_append_region(region, p_mesh_id, xforms.ptr(), colors.ptr(), xforms.size(), p_clear);
 }
 
 // Review all transforms in one area and adjust their transforms w/ the current height
@@ -464,57 +1165,226 @@ void Terrain3DInstancer::update_transforms(const AABB &p_aabb) {
 	IS_DATA_INIT_MESG("Instancer isn't initialized.", VOID);
 	LOG(DEBUG_CONT, "Updating transforms for all meshes within ", p_aabb);
 
-	Array region_locations = _terrain->get_data()->get_region_locations();
+	// Review only the cells in the area, for all mesh ids
 	Rect2 brush_rect = aabb2rect(p_aabb);
-	for (int r = 0; r < region_locations.size(); r++) {
-		Vector2i region_loc = region_locations[r];
-		Ref<Terrain3DRegion> region = _terrain->get_data()->get_region(region_loc);
-		if (region.is_null()) {
-			LOG(WARN, "No region found at: ", region_loc);
+	LocalVector<CellRef> cells;
+	_find_cells(brush_rect, -1, cells);
+	LOG(DEBUG_CONT, "Found ", cells.size(), " cells within ", brush_rect);
+	for (const CellRef &cell_ref : cells) {
+		Ref<Terrain3DMeshAsset> mesh_asset = _terrain->get_assets()->get_mesh_asset(cell_ref.mesh_id);
+		if (mesh_asset.is_null()) {
 			continue;
 		}
-		int region_size = _terrain->get_region_size();
-		Rect2 region_rect;
-		region_rect.set_position(region_loc * region_size);
-		region_rect.set_size(Vector2(region_size, region_size));
-		LOG(DEBUG_CONT, "RO: ", region_loc, " RAABB: ", region_rect, " intersects: ", brush_rect.intersects(region_rect));
-
-		// If specified area includes this region, update all MMs within
-		if (brush_rect.intersects(region_rect)) {
-			Dictionary mesh_dict = region->get_multimeshes();
-			LOG(DEBUG_CONT, "Region ", region_loc, " intersect AABB and contains ", mesh_dict.size(), " mesh types");
-			// For all mesh ids
-			for (int m = 0; m < mesh_dict.keys().size(); m++) {
-				int mesh_id = mesh_dict.keys()[m];
-				Ref<MultiMesh> mm = mesh_dict.get(mesh_id, Ref<MultiMesh>());
-				if (mm.is_null()) {
+		Ref<MultiMesh> mm = cell_ref.mm;
+		// Update the instances in place, compacting any that fell in holes
+		int instance_count = _get_instance_count(mm);
+		PackedRealArray buffer = mm->get_buffer();
+		real_t *b = buffer.ptrw();
+		int write = 0;
+		bool modified = false;
+		for (int i = 0; i < instance_count; i++) {
+			real_t *src = b + i * MM_STRIDE;
+			Vector3 origin = Vector3(src[3], src[7], src[11]);
+			if (brush_rect.has_point(Vector2(origin.x, origin.z))) {
+				// Reset height to terrain height + mesh height offset along UP axis
+				real_t height = _terrain->get_data()->get_height(origin);
+				// If the new height is a nan due to creating a hole, remove the instance
+				if (std::isnan(height)) {
+					modified = true;
 					continue;
 				}
-				Ref<Terrain3DMeshAsset> mesh_asset = _terrain->get_assets()->get_mesh_asset(mesh_id);
-				TypedArray<Transform3D> xforms;
-				TypedArray<Color> colors;
-				LOG(DEBUG_CONT, "Multimesh ", mesh_id, " has ", mm->get_instance_count(), " to review");
-				for (int i = 0; i < mm->get_instance_count(); i++) {
-					Transform3D t = mm->get_instance_transform(i);
-					if (brush_rect.has_point(Vector2(t.origin.x, t.origin.z))) {
-						// Reset height to terrain height + mesh height offset along UP axis
-						real_t height = _terrain->get_data()->get_height(t.origin);
-						// If the new height is a nan due to creating a hole, remove the instance
-						if (std::isnan(height)) {
-							continue;
-						}
-						t.origin.y = height + mesh_asset->get_height_offset();
-					}
-					xforms.push_back(t);
-					colors.push_back(mm->get_instance_color(i));
+				real_t new_y = height + mesh_asset->get_height_offset();
+				if (new_y != origin.y) {
+					src[7] = new_y;
+					modified = true;
 				}
-				// Replace multimesh
-				append_multimesh(region_loc, mesh_id, xforms, colors, true);
 			}
+			if (write != i) {
+				memcpy(b + write * MM_STRIDE, src, MM_STRIDE * sizeof(real_t));
+			}
+			write++;
+		}
+		if (modified) {
+			_compact_cell(cell_ref.region, cell_ref.mesh_id, cell_ref.cell, buffer, write);
 		}
 	}
 }
 
+// Places instances over an area following rules, filling each cell in the area on the WorkerThreadPool
+void Terrain3DInstancer::scatter(const int p_mesh_id, const AABB &p_area, const Dictionary &p_rules) {
+	IS_DATA_INIT_MESG("Instancer isn't initialized.", VOID);
+	if (p_mesh_id < 0 || p_mesh_id >= _terrain->get_assets()->get_mesh_count()) {
+		LOG(ERROR, "Mesh ID out of range: ", p_mesh_id, ", valid: 0 to ", _terrain->get_assets()->get_mesh_count() - 1);
+		return;
+	}
+	Ref<Terrain3DMeshAsset> mesh_asset = _terrain->get_assets()->get_mesh_asset(p_mesh_id);
+	Terrain3DData *data = _terrain->get_data();
+
+	_scatter.params = _get_instance_params(p_rules);
+	_scatter.seed = uint32_t(int64_t(p_rules.get("seed", 0)));
+	_scatter.spacing = CLAMP(real_t(p_rules.get("spacing", 2.f)), .1f, 1000.f); // meters
+	_scatter.jitter = CLAMP(real_t(p_rules.get("jitter", 1.f)), 0.f, 1.f);
+	real_t slope_min = CLAMP(real_t(p_rules.get("slope_min", 0.f)), 0.f, 90.f); // degrees
+	real_t slope_max = CLAMP(real_t(p_rules.get("slope_max", 90.f)), 0.f, 90.f);
+	_scatter.cos_slope_min = Math::cos(Math::deg_to_rad(slope_min));
+	_scatter.cos_slope_max = Math::cos(Math::deg_to_rad(slope_max));
+	_scatter.height_min = p_rules.get("height_min", -FLT_MAX);
+	_scatter.height_max = p_rules.get("height_max", FLT_MAX);
+	Array textures = p_rules.get("textures", Array());
+	for (int i = 0; i < textures.size(); i++) {
+		int id = textures[i];
+		if (id < 0 || id >= Terrain3DAssets::MAX_TEXTURES) {
+			LOG(WARN, "Texture ID out of range, ignoring: ", id);
+			continue;
+		}
+		_scatter.texture_mask |= 1u << id;
+	}
+	_scatter.texture_threshold = CLAMP(real_t(p_rules.get("texture_threshold", .5f)), 0.f, 1.f);
+	_scatter.navigation = CLAMP(int(p_rules.get("navigation", 0)), 0, 2);
+	_scatter.mesh_height_offset = mesh_asset->get_height_offset();
+	_scatter.region_size = _terrain->get_region_size();
+	_scatter.vertex_spacing = _terrain->get_mesh_vertex_spacing();
+	bool clear = p_rules.get("clear", true);
+
+	// Split the area into tiles, one per cell in active regions
+	Rect2 rect = aabb2rect(p_area);
+	int cells_per_side = _scatter.region_size / CELL_SIZE;
+	real_t cell_width = _scatter.vertex_spacing * CELL_SIZE;
+	Vector2i cell_min = Vector2i((rect.position / cell_width).floor());
+	Vector2i cell_max = Vector2i((rect.get_end() / cell_width).floor());
+	for (int cy = cell_min.y; cy <= cell_max.y; cy++) {
+		for (int cx = cell_min.x; cx <= cell_max.x; cx++) {
+			Vector2i global_cell = Vector2i(cx, cy);
+			Vector2i region_loc = Vector2i((Vector2(global_cell) / real_t(cells_per_side)).floor());
+			if (!data->has_region(region_loc)) {
+				continue;
+			}
+			Rect2 area = rect.intersection(Rect2(Vector2(global_cell) * cell_width, Vector2(cell_width, cell_width)));
+			if (!area.has_area()) {
+				continue;
+			}
+			ScatterTile tile;
+			tile.region = data->get_region(region_loc);
+			tile.region->load_maps((1 << TYPE_HEIGHT) | (1 << TYPE_CONTROL));
+			tile.region_offset = region_loc * _scatter.region_size;
+			tile.cell = global_cell - region_loc * cells_per_side;
+			tile.rect = area;
+			tile.height = tile.region->get_height_map()->ptr();
+			tile.half = is_half_height(tile.region->get_height_map());
+			tile.control = reinterpret_cast<const uint32_t *>(tile.region->get_control_map()->ptr());
+			_scatter.tiles.push_back(tile);
+		}
+	}
+	LOG(INFO, "Scattering mesh ", p_mesh_id, " over ", rect, " in ", _scatter.tiles.size(), " cells, spacing: ", _scatter.spacing,
+			", seed: ", _scatter.seed);
+
+	Util::run_group_task(callable_mp(this, &Terrain3DInstancer::_scatter_tile), _scatter.tiles.size(), "Terrain3D scatter");
+
+	// Write each tile into its cell. Clear replaces the instances in the area, keeping the rest of the cell
+	uint32_t total = 0;
+	for (ScatterTile &tile : _scatter.tiles) {
+		uint32_t count = tile.xforms.size();
+		Ref<MultiMesh> mm;
+		if (clear) {
+			Dictionary mesh_dict = tile.region->get_multimeshes();
+			Dictionary cell_dict = mesh_dict.get(p_mesh_id, Dictionary());
+			mm = cell_dict.get(tile.cell, Ref<MultiMesh>());
+			int old_count = _get_instance_count(mm);
+			for (int i = 0; i < old_count; i++) {
+				Transform3D t = mm->get_instance_transform(i);
+				if (!tile.rect.has_point(Vector2(t.origin.x, t.origin.z))) {
+					tile.xforms.push_back(t);
+					tile.colors.push_back(mm->get_instance_color(i));
+				}
+			}
+		}
+		if (tile.xforms.is_empty() && mm.is_null()) {
+			continue;
+		}
+		_backup_region(tile.region);
+		_append_cell(tile.region, p_mesh_id, tile.cell, tile.xforms.ptr(), tile.colors.ptr(), tile.xforms.size(), clear);
+		total += count;
+	}
+	LOG(INFO, "Scattered ", total, " instances");
+	_scatter = ScatterJob();
+}
+
+// Returns the handles and transforms of instances w/ origins inside of a global area
+Dictionary Terrain3DInstancer::query_instances(const AABB &p_area, const int64_t p_mesh_mask) const {
+	return _query_instances(p_area.abs(), -1.f, p_mesh_mask);
+}
+
+// Returns the handles and transforms of instances w/ origins within a sphere
+Dictionary Terrain3DInstancer::query_instances_radius(const Vector3 &p_center, const real_t p_radius, const int64_t p_mesh_mask) const {
+	real_t radius = MAX(0.f, p_radius);
+	AABB area = AABB(p_center - Vector3(radius, radius, radius), Vector3(radius, radius, radius) * 2.f);
+	return _query_instances(area, radius, p_mesh_mask);
+}
+
+// Removes instances by the handles returned from query_instances(). Handles are sorted so each
+// cell is compacted once. Handles of cells edited since the query may remove other instances.
+void Terrain3DInstancer::remove_instances_by_handle(const PackedInt64Array &p_handles) {
+	IS_DATA_INIT_MESG("Instancer isn't initialized.", VOID);
+	if (p_handles.is_empty()) {
+		return;
+	}
+	PackedInt64Array handles = p_handles.duplicate();
+	handles.sort();
+	const int64_t *ptr = handles.ptr();
+	int64_t size = handles.size();
+	int cells_per_side = _terrain->get_region_size() / CELL_SIZE;
+	const int64_t instance_mask = (int64_t(1) << HANDLE_INSTANCE_BITS) - 1;
+	uint32_t removed = 0;
+
+	int64_t start = 0;
+	while (start < size) {
+		// Handles of one cell share all bits above the instance index
+		int64_t cell_bits = ptr[start] >> HANDLE_INSTANCE_BITS;
+		int64_t end = start + 1;
+		while (end < size && (ptr[end] >> HANDLE_INSTANCE_BITS) == cell_bits) {
+			end++;
+		}
+		int cell_index = cell_bits & ((1 << HANDLE_CELL_BITS) - 1);
+		int region_index = (cell_bits >> HANDLE_CELL_BITS) & ((1 << HANDLE_REGION_BITS) - 1);
+		int mesh_id = cell_bits >> (HANDLE_CELL_BITS + HANDLE_REGION_BITS);
+		Vector2i region_loc = Vector2i(region_index % Terrain3DData::REGION_MAP_SIZE, region_index / Terrain3DData::REGION_MAP_SIZE) -
+				Terrain3DData::REGION_MAP_VSIZE / 2;
+		Vector2i cell = Vector2i(cell_index % cells_per_side, cell_index / cells_per_side);
+		Ref<Terrain3DRegion> region = _terrain->get_data()->get_region(region_loc);
+		Ref<MultiMesh> mm = region.is_valid() ? get_multimesh(region_loc, mesh_id, cell) : Ref<MultiMesh>();
+		int count = _get_instance_count(mm);
+		if (ptr[start] < 0 || count == 0) {
+			LOG(WARN, "Skipping ", end - start, " invalid handles at region: ", region_loc, " mesh_id: ", mesh_id, " cell: ", cell);
+			start = end;
+			continue;
+		}
+
+		// Compact the remaining instances in place
+		PackedRealArray buffer = mm->get_buffer();
+		real_t *b = buffer.ptrw();
+		int64_t next = start;
+		int write = 0;
+		for (int i = 0; i < count; i++) {
+			while (next < end && (ptr[next] & instance_mask) < i) {
+				next++;
+			}
+			if (next < end && (ptr[next] & instance_mask) == i) {
+				continue;
+			}
+			if (write != i) {
+				memcpy(b + write * MM_STRIDE, b + i * MM_STRIDE, MM_STRIDE * sizeof(real_t));
+			}
+			write++;
+		}
+		if (write < count) {
+			removed += count - write;
+			_compact_cell(region, mesh_id, cell, buffer, write);
+		}
+		start = end;
+	}
+	LOG(DEBUG, "Removed ", removed, " instances by handle");
+}
+
 // Changes the ID of a mesh, without changing the mesh on the ground
 // Called when the mesh asset id has changed. Updates Multimeshes and MMIs dictionary keys
 void Terrain3DInstancer::swap_ids(const int p_src_id, const int p_dst_id) {
@@ -534,9 +1404,9 @@ void Terrain3DInstancer::swap_ids(const int p_src_id, const int p_dst_id) {
 			}
 			Dictionary mesh_dict = region->get_multimeshes();
 			// mesh_dict could have src, src&dst, dst or nothing. All 4 must be considered
-			// Pop out any existing MMs
-			Ref<MultiMesh> mm_src;
-			Ref<MultiMesh> mm_dst;
+			// Pop out any existing cell dictionaries
+			Dictionary mm_src;
+			Dictionary mm_dst;
 			if (mesh_dict.has(p_src_id)) {
 				_backup_region(region);
 				mm_src = mesh_dict[p_src_id];
@@ -548,85 +1418,215 @@ void Terrain3DInstancer::swap_ids(const int p_src_id, const int p_dst_id) {
 				mesh_dict.erase(p_dst_id);
 			}
 			// If src is ok, insert into dst slot
-			if (mm_src.is_valid()) {
+			if (!mm_src.is_empty()) {
 				_backup_region(region);
 				mesh_dict[p_dst_id] = mm_src;
 			}
 			// If dst is ok, insert into src slot
-			if (mm_dst.is_valid()) {
+			if (!mm_dst.is_empty()) {
 				_backup_region(region);
 				mesh_dict[p_src_id] = mm_dst;
 			}
 			LOG(DEBUG, "Swapped multimesh ids at: ", region_loc);
 		}
 
-		// Change key in _mmi dictionary
-		Array mmi_keys = _mmis.keys();
-		Dictionary to_src_mmis;
-		Dictionary to_dst_mmis;
-
-		for (int i = 0; i < mmi_keys.size(); i++) {
-			Vector3i key = mmi_keys[i];
-			if (key.z == p_src_id) {
-				Vector3i dst_key = key; // setup destination key
-				dst_key.z = p_dst_id;
-				to_dst_mmis[dst_key] = _mmis[key]; // store MMI under dest key
-				_mmis.erase(key);
-			} else if (key.z == p_dst_id) {
-				Vector3i src_key = key; // setup source key
-				src_key.z = p_src_id;
-				to_src_mmis[src_key] = _mmis[key]; // store MMI under src key
-				_mmis.erase(key);
+		// Change mesh id of the cell instance keys
+		LocalVector<CellKey> keys;
+		LocalVector<CellInstances> swapped;
+		for (const KeyValue<CellKey, CellInstances> &E : _cell_instances) {
+			if (E.key.mesh_id == p_src_id || E.key.mesh_id == p_dst_id) {
+				keys.push_back(E.key);
+				swapped.push_back(E.value);
 			}
 		}
-		_mmis.merge(to_src_mmis);
-		_mmis.merge(to_dst_mmis);
+		for (const CellKey &key : keys) {
+			_cell_instances.erase(key);
+		}
+		for (uint32_t i = 0; i < keys.size(); i++) {
+			CellKey key = keys[i];
+			key.mesh_id = (key.mesh_id == p_src_id) ? p_dst_id : p_src_id;
+			_cell_instances.insert(key, swapped[i]);
+		}
 		LOG(DEBUG, "Swapped multimesh instance ids");
 	}
 }
 
 Ref<MultiMesh> Terrain3DInstancer::get_multimeshp(const Vector3 &p_global_position, const int p_mesh_id) const {
+	IS_DATA_INIT(Ref<MultiMesh>());
 	Vector2i region_loc = _terrain->get_data()->get_region_location(p_global_position);
-	return get_multimesh(region_loc, p_mesh_id);
+	Vector2i cell = _get_cell(p_global_position, _terrain->get_region_size());
+	return get_multimesh(region_loc, p_mesh_id, cell);
 }
 
+Ref<MultiMesh> Terrain3DInstancer::get_multimesh(const Vector2i &p_region_loc, const int p_mesh_id, const Vector2i &p_cell) const {
+	IS_DATA_INIT(Ref<MultiMesh>());
+	Ref<Terrain3DRegion> region = _terrain->get_data()->get_region(p_region_loc);
+	if (region.is_null()) {
+		LOG(WARN, "No region found at: ", p_region_loc);
+		return Ref<MultiMesh>();
+	}
+	Dictionary mesh_dict = region->get_multimeshes();
+	Dictionary cell_dict = mesh_dict.get(p_mesh_id, Dictionary());
+	Ref<MultiMesh> mm = cell_dict.get(p_cell, Ref<MultiMesh>());
+	LOG(DEBUG_CONT, "Retrieving MultiMesh at region: ", p_region_loc, " mesh_id: ", p_mesh_id, " cell: ", p_cell, " : ", mm);
+	return mm;
+}
+
+// Deprecated since instances were split into cells. Returns a new MultiMesh merging all cells of a
+// mesh in a region. Edits to it aren't stored.
 Ref<MultiMesh> Terrain3DInstancer::get_multimesh(const Vector2i &p_region_loc, const int p_mesh_id) const {
 	IS_DATA_INIT(Ref<MultiMesh>());
+	LOG(WARN, "get_multimesh() without a cell is deprecated and returns a copy. Use get_multimesh() with a cell, or get_instances_buffer()");
 	Ref<Terrain3DRegion> region = _terrain->get_data()->get_region(p_region_loc);
 	if (region.is_null()) {
 		LOG(WARN, "No region found at: ", p_region_loc);
 		return Ref<MultiMesh>();
 	}
 	Dictionary mesh_dict = region->get_multimeshes();
-	Ref<MultiMesh> mm = mesh_dict.get(p_mesh_id, Ref<MultiMesh>());
-	LOG(DEBUG_CONT, "Retrieving MultiMesh at region: ", p_region_loc, " mesh_id: ", p_mesh_id, " : ", mm);
+	Dictionary cell_dict = mesh_dict.get(p_mesh_id, Dictionary());
+	Array cells = cell_dict.keys();
+	PackedRealArray merged;
+	for (int c = 0; c < cells.size(); c++) {
+		Ref<MultiMesh> mm = cell_dict[cells[c]];
+		int count = _get_instance_count(mm);
+		if (count == 0) {
+			continue;
+		}
+		int64_t offset = merged.size();
+		merged.resize(offset + count * MM_STRIDE);
+		memcpy(merged.ptrw() + offset, mm->get_buffer().ptr(), count * MM_STRIDE * sizeof(real_t));
+	}
+	if (merged.is_empty()) {
+		return Ref<MultiMesh>();
+	}
+	Ref<MultiMesh> mm;
+	mm.instantiate();
+	mm->set_transform_format(MultiMesh::TRANSFORM_3D);
+	mm->set_use_colors(true);
+	Ref<Terrain3DMeshAsset> ma = _terrain->get_assets()->get_mesh_asset(p_mesh_id);
+	if (ma.is_valid()) {
+		mm->set_mesh(ma->get_mesh());
+	}
+	mm->set_instance_count(merged.size() / MM_STRIDE);
+	mm->set_buffer(merged);
 	return mm;
 }
 
+// Returns the RenderingServer instance drawing a LOD of a cell, or an empty RID
+RID Terrain3DInstancer::get_instance_rid(const Vector2i &p_region_loc, const int p_mesh_id, const Vector2i &p_cell, const int p_lod) const {
+	const CellInstances *ci = _cell_instances.getptr({ p_region_loc, p_cell, p_mesh_id });
+	RID rid;
+	if (ci && p_lod >= 0 && p_lod < int(ci->instances.size())) {
+		rid = ci->instances[p_lod];
+	}
+	LOG(DEBUG_CONT, "Retrieving instance at region: ", p_region_loc, " mesh_id: ", p_mesh_id, " cell: ", p_cell, " lod: ", p_lod, " : ", rid);
+	return rid;
+}
+
+// Deprecated. Instances are drawn by RenderingServer instances, not MultiMeshInstance3D nodes
 MultiMeshInstance3D *Terrain3DInstancer::get_multimesh_instancep(const Vector3 &p_global_position, const int p_mesh_id) const {
-	Vector2i region_loc = _terrain->get_data()->get_region_location(p_global_position);
-	return get_multimesh_instance(region_loc, p_mesh_id);
+	return get_multimesh_instance(V2I_ZERO, p_mesh_id);
 }
 
 MultiMeshInstance3D *Terrain3DInstancer::get_multimesh_instance(const Vector2i &p_region_loc, const int p_mesh_id) const {
-	Vector3i key = Vector3i(p_region_loc.x, p_region_loc.y, p_mesh_id);
-	MultiMeshInstance3D *mmi = cast_to<MultiMeshInstance3D>(_mmis[key]);
-	LOG(DEBUG_CONT, "Retrieving MultiMeshInstance3D at region: ", p_region_loc, " mesh_id: ", p_mesh_id, " : ", mmi);
-	return mmi;
+	LOG(ERROR, "get_multimesh_instance() is deprecated and returns null. Instances are no longer drawn by nodes. Use get_instance_rid()");
+	return nullptr;
 }
 
-void Terrain3DInstancer::set_cast_shadows(const int p_mesh_id, const GeometryInstance3D::ShadowCastingSetting p_cast_shadows) {
-	LOG(INFO, "Setting shadow casting on MMIS with mesh: ", p_mesh_id, " to mode: ", p_cast_shadows);
-	Array keys = _mmis.keys();
-	for (int i = 0; i < keys.size(); i++) {
-		Vector3i key = keys[i];
-		if (key.z == p_mesh_id) {
-			MultiMeshInstance3D *mmi = cast_to<MultiMeshInstance3D>(_mmis[key]);
-			if (mmi) {
-				mmi->set_cast_shadows_setting(p_cast_shadows);
+// Builds a Dictionary of the instance RIDs for inspection
+Dictionary Terrain3DInstancer::get_mmis() const {
+	Dictionary mmis;
+	for (const KeyValue<CellKey, CellInstances> &E : _cell_instances) {
+		Vector3i key = Vector3i(E.key.region_loc.x, E.key.region_loc.y, E.key.mesh_id);
+		if (!mmis.has(key)) {
+			mmis[key] = Dictionary();
+		}
+		Dictionary cells = mmis[key];
+		Array rids;
+		for (const RID &rid : E.value.instances) {
+			rids.push_back(rid);
+		}
+		cells[E.key.cell] = rids;
+	}
+	return mmis;
+}
+
+// Returns the transforms of all instances of a mesh in a region, ordered by cell, in the layout of add_instances_buffer()
+PackedFloat32Array Terrain3DInstancer::get_instances_buffer(const Vector2i &p_region_loc, const int p_mesh_id) const {
+	IS_DATA_INIT(PackedFloat32Array());
+	PackedFloat32Array xforms;
+	Ref<Terrain3DRegion> region = _terrain->get_data()->get_region(p_region_loc);
+	if (region.is_null()) {
+		LOG(WARN, "No region found at: ", p_region_loc);
+		return xforms;
+	}
+	Dictionary mesh_dict = region->get_multimeshes();
+	Dictionary cell_dict = mesh_dict.get(p_mesh_id, Dictionary());
+	Array cells = cell_dict.keys();
+	for (int c = 0; c < cells.size(); c++) {
+		Ref<MultiMesh> mm = cell_dict[cells[c]];
+		int count = _get_instance_count(mm);
+		if (count == 0) {
+			continue;
+		}
+		PackedRealArray buffer = mm->get_buffer();
+		const real_t *src = buffer.ptr();
+		int64_t offset = xforms.size();
+		xforms.resize(offset + count * 12);
+		float *dst = xforms.ptrw() + offset;
+		for (int i = 0; i < count; i++) {
+			for (int k = 0; k < 12; k++) {
+				dst[i * 12 + k] = src[i * MM_STRIDE + k];
 			}
 		}
 	}
+	return xforms;
+}
+
+// Returns the colors of all instances of a mesh in a region, in the same order as get_instances_buffer()
+PackedColorArray Terrain3DInstancer::get_instances_colors(const Vector2i &p_region_loc, const int p_mesh_id) const {
+	IS_DATA_INIT(PackedColorArray());
+	PackedColorArray colors;
+	Ref<Terrain3DRegion> region = _terrain->get_data()->get_region(p_region_loc);
+	if (region.is_null()) {
+		LOG(WARN, "No region found at: ", p_region_loc);
+		return colors;
+	}
+	Dictionary mesh_dict = region->get_multimeshes();
+	Dictionary cell_dict = mesh_dict.get(p_mesh_id, Dictionary());
+	Array cells = cell_dict.keys();
+	for (int c = 0; c < cells.size(); c++) {
+		Ref<MultiMesh> mm = cell_dict[cells[c]];
+		int count = _get_instance_count(mm);
+		if (count == 0) {
+			continue;
+		}
+		PackedRealArray buffer = mm->get_buffer();
+		const real_t *src = buffer.ptr() + 12;
+		int64_t offset = colors.size();
+		colors.resize(offset + count);
+		Color *dst = colors.ptrw() + offset;
+		for (int i = 0; i < count; i++) {
+			const real_t *col = src + i * MM_STRIDE;
+			dst[i] = Color(col[0], col[1], col[2], col[3]);
+		}
+	}
+	return colors;
+}
+
+// Far LODs may have shadows disabled by the mesh asset, which overrides the mode given
+void Terrain3DInstancer::set_cast_shadows(const int p_mesh_id, const GeometryInstance3D::ShadowCastingSetting p_cast_shadows) {
+	LOG(INFO, "Setting shadow casting on instances with mesh: ", p_mesh_id, " to mode: ", p_cast_shadows);
+	Ref<Terrain3DMeshAsset> ma = _terrain->get_assets()->get_mesh_asset(p_mesh_id);
+	for (const KeyValue<CellKey, CellInstances> &E : _cell_instances) {
+		if (E.key.mesh_id != p_mesh_id) {
+			continue;
+		}
+		for (uint32_t lod = 0; lod < E.value.instances.size(); lod++) {
+			GeometryInstance3D::ShadowCastingSetting mode = ma.is_valid() ? ma->get_lod_cast_shadows(lod) : p_cast_shadows;
+			RS->instance_geometry_set_cast_shadows_setting(E.value.instances[lod], RenderingServer::ShadowCastingSetting(mode));
+		}
+	}
 }
 
 void Terrain3DInstancer::force_update_mmis() {
@@ -634,25 +1634,47 @@ void Terrain3DInstancer::force_update_mmis() {
 	_update_mmis();
 }
 
-void Terrain3DInstancer::print_multimesh_buffer(MultiMeshInstance3D *p_mmi) const {
-	if (p_mmi == nullptr) {
+// Instances of mesh assets w/ collision enabled get collision near each target, or the camera if none
+void Terrain3DInstancer::add_collision_target(Node3D *p_target) {
+	if (p_target == nullptr) {
+		return;
+	}
+	uint64_t id = p_target->get_instance_id();
+	if (_collision_targets.find(id) < 0) {
+		LOG(INFO, "Adding collision target: ", p_target->get_name());
+		_collision_targets.push_back(id);
+		_collision_dirty = true;
+	}
+}
+
+void Terrain3DInstancer::remove_collision_target(Node3D *p_target) {
+	if (p_target == nullptr) {
+		return;
+	}
+	LOG(INFO, "Removing collision target: ", p_target->get_name());
+	_collision_targets.erase(p_target->get_instance_id());
+	_collision_dirty = true;
+}
+
+void Terrain3DInstancer::print_multimesh_buffer(const Ref<MultiMesh> &p_mm) const {
+	if (p_mm.is_null()) {
 		return;
 	}
-	Ref<MultiMesh> mm = p_mmi->get_multimesh();
-	PackedRealArray b = mm->get_buffer();
-	UtilityFunctions::print("MM instance count: ", mm->get_instance_count());
-	int mmsize = b.size();
-	if (mmsize <= 12 || mmsize % 12 != 0) {
-		UtilityFunctions::print("MM buffer size not a multiple of 12: ", mmsize);
+	PackedRealArray b = p_mm->get_buffer();
+	UtilityFunctions::print("MM instance count: ", _get_instance_count(p_mm), ", capacity: ", p_mm->get_instance_count());
+	int stride = b.size() / MAX(1, p_mm->get_instance_count());
+	if (stride < 12) {
+		UtilityFunctions::print("MM buffer has less than 12 floats per instance: ", b.size());
 		return;
 	}
-	for (int i = 0; i < mmsize; i += 12) {
+	int mmsize = _get_instance_count(p_mm) * stride;
+	for (int i = 0; i < mmsize; i += stride) {
 		Transform3D tfm;
 		tfm.set(b[i + 0], b[i + 1], b[i + 2], // basis x
 				b[i + 4], b[i + 5], b[i + 6], // basis y
 				b[i + 8], b[i + 9], b[i + 10], // basis z
 				b[i + 3], b[i + 7], b[i + 11]); // origin
-		UtilityFunctions::print(i / 12, ": ", tfm);
+		UtilityFunctions::print(i / stride, ": ", tfm);
 	}
 }
 
@@ -667,11 +1689,20 @@ void Terrain3DInstancer::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("remove_instances", "global_position", "params"), &Terrain3DInstancer::remove_instances);
 	ClassDB::bind_method(D_METHOD("add_multimesh", "mesh_id", "multimesh", "transform"), &Terrain3DInstancer::add_multimesh, DEFVAL(Transform3D()));
 	ClassDB::bind_method(D_METHOD("add_transforms", "mesh_id", "transforms", "colors"), &Terrain3DInstancer::add_transforms, DEFVAL(TypedArray<Color>()));
+	ClassDB::bind_method(D_METHOD("add_instances_buffer", "mesh_id", "transforms", "colors"), &Terrain3DInstancer::add_instances_buffer, DEFVAL(PackedColorArray()));
 	ClassDB::bind_method(D_METHOD("append_multimesh", "region_location", "mesh_id", "transforms", "colors", "clear"), &Terrain3DInstancer::append_multimesh, DEFVAL(false));
 	ClassDB::bind_method(D_METHOD("update_transforms", "aabb"), &Terrain3DInstancer::update_transforms);
+	ClassDB::bind_method(D_METHOD("scatter", "mesh_id", "area", "rules"), &Terrain3DInstancer::scatter);
+	ClassDB::bind_method(D_METHOD("query_instances", "area", "mesh_mask"), &Terrain3DInstancer::query_instances, DEFVAL(-1));
+	ClassDB::bind_method(D_METHOD("query_instances_radius", "center", "radius", "mesh_mask"), &Terrain3DInstancer::query_instances_radius, DEFVAL(-1));
+	ClassDB::bind_method(D_METHOD("remove_instances_by_handle", "handles"), &Terrain3DInstancer::remove_instances_by_handle);
 
 	ClassDB::bind_method(D_METHOD("swap_ids", "src_id", "dest_id"), &Terrain3DInstancer::swap_ids);
+	ClassDB::bind_method(D_METHOD("get_instances_buffer", "region_location", "mesh_id"), &Terrain3DInstancer::get_instances_buffer);
+	ClassDB::bind_method(D_METHOD("get_instances_colors", "region_location", "mesh_id"), &Terrain3DInstancer::get_instances_colors);
 	ClassDB::bind_method(D_METHOD("get_mmis"), &Terrain3DInstancer::get_mmis);
 	ClassDB::bind_method(D_METHOD("set_cast_shadows", "mesh_id", "mode"), &Terrain3DInstancer::set_cast_shadows);
 	ClassDB::bind_method(D_METHOD("force_update_mmis"), &Terrain3DInstancer::force_update_mmis);
+	ClassDB::bind_method(D_METHOD("add_collision_target", "target"), &Terrain3DInstancer::add_collision_target);
+	ClassDB::bind_method(D_METHOD("remove_collision_target", "target"), &Terrain3DInstancer::remove_collision_target);
 }
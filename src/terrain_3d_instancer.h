@@ -3,8 +3,11 @@
 #ifndef TERRAIN3D_INSTANCER_CLASS_H
 #define TERRAIN3D_INSTANCER_CLASS_H
 
+#include <godot_cpp/classes/geometry_instance3d.hpp>
 #include <godot_cpp/classes/multi_mesh.hpp>
 #include <godot_cpp/classes/multi_mesh_instance3d.hpp>
+#include <godot_cpp/templates/hash_map.hpp>
+#include <godot_cpp/templates/local_vector.hpp>
 
 #include "constants.h"
 
@@ -12,25 +15,163 @@ using namespace godot;
 
 class Terrain3D;
 class Terrain3DAssets;
+class Terrain3DRegion;
 
 class Terrain3DInstancer : public Object {
 	GDCLASS(Terrain3DInstancer, Object);
 	CLASS_NAME();
 	friend Terrain3D;
 
+public: // Constants
+	// Floats per instance in a MultiMesh buffer w/ TRANSFORM_3D and colors
+	static inline const int MM_STRIDE = 16;
+	// Instances are split into square cells of this many vertices per side, each w/ its own MultiMesh
+	static inline const int CELL_SIZE = 32;
+	// Bits of an instance handle, from low to high: instance index, cell index, region map index, then mesh id
+	static inline const int HANDLE_INSTANCE_BITS = 20;
+	static inline const int HANDLE_CELL_BITS = 12;
+	static inline const int HANDLE_REGION_BITS = 8;
+	// Instances per cell, limited so their index fits in a handle
+	static inline const int MAX_CELL_INSTANCES = 1 << HANDLE_INSTANCE_BITS;
+	// Instance collision is reassigned when a target moves this many meters
+	static inline const real_t COLLISION_UPDATE_DISTANCE = 1.f;
+
+private:
 	Terrain3D *_terrain = nullptr;
 
 	// MM Resources stored in Terrain3DRegion::_multimeshes as
-	// Dictionary[mesh_id:int] -> MultiMesh
-	// MMI Objects attached to tree, freed in destructor, stored as
-	// Dictionary[Vector3i(region_location.x, region_location.y, mesh_id)] -> MultiMeshInstance3D
-	Dictionary _mmis;
+	// Dictionary[mesh_id:int] -> Dictionary[cell:Vector2i] -> MultiMesh
+	// Cells are indexed from the region origin.
+	// Each cell is drawn by RenderingServer instances, one per LOD, see Terrain3DMeshAsset::get_lod_count()
+	// LOD0 draws the stored MultiMesh. Other LODs draw a copy of it owned here, w/ their own mesh.
+	struct CellKey {
+		Vector2i region_loc;
+		Vector2i cell;
+		int mesh_id = -1;
+
+		bool operator==(const CellKey &p_other) const {
+			return region_loc == p_other.region_loc && cell == p_other.cell && mesh_id == p_other.mesh_id;
+		}
+	};
+	struct CellKeyHasher {
+		static _FORCE_INLINE_ uint32_t hash(const CellKey &p_key) {
+			uint32_t h = hash_murmur3_one_32(p_key.region_loc.x);
+			h = hash_murmur3_one_32(p_key.region_loc.y, h);
+			h = hash_murmur3_one_32(p_key.cell.x, h);
+			h = hash_murmur3_one_32(p_key.cell.y, h);
+			h = hash_murmur3_one_32(p_key.mesh_id, h);
+			return hash_fmix32(h);
+		}
+	};
+	struct CellInstances {
+		LocalVector<RID> instances; // Per LOD
+		LocalVector<RID> multimeshes; // Per LOD, copies for LOD1+, empty RID for LOD0
+	};
+	// Freed in destroy()
+	HashMap<CellKey, CellInstances, CellKeyHasher> _cell_instances;
+
+	// A cell MultiMesh found by _find_cells()
+	struct CellRef {
+		Ref<Terrain3DRegion> region;
+		int mesh_id = -1;
+		Vector2i cell;
+		Ref<MultiMesh> mm;
+	};
+
+	// Settings for randomizing instance transforms and colors, see _get_instance_params()
+	struct InstanceParams {
+		real_t fixed_scale = 1.f;
+		real_t random_scale = 0.f;
+		real_t fixed_spin = 0.f; // Degrees
+		real_t random_spin = 360.f;
+		real_t fixed_angle = 0.f;
+		real_t random_angle = 10.f;
+		bool align_to_normal = false;
+		real_t height_offset = 0.f; // Meters
+		real_t random_height = 0.f;
+		Color vertex_color = COLOR_WHITE;
+		real_t random_hue = 0.f; // 0-1
+		real_t random_darken = 0.f;
+	};
+
+	// Rules and tiles for scatter(), shared with the worker threads. Each tile is the part of one cell in the area.
+	struct ScatterTile {
+		Ref<Terrain3DRegion> region;
+		Vector2i region_offset; // In global pixels
+		Vector2i cell;
+		Rect2 rect; // Global area, within the cell
+		const uint8_t *height = nullptr; // Maps of the region
+		bool half = false; // Height map format, see is_half_height()
+		const uint32_t *control = nullptr;
+		LocalVector<Transform3D> xforms;
+		LocalVector<Color> colors;
+	};
+	struct ScatterJob {
+		LocalVector<ScatterTile> tiles;
+		InstanceParams params;
+		uint32_t seed = 0;
+		real_t spacing = 1.f;
+		real_t jitter = 1.f;
+		real_t cos_slope_min = 1.f; // Cosines of the slope range
+		real_t cos_slope_max = 0.f;
+		real_t height_min = -FLT_MAX;
+		real_t height_max = FLT_MAX;
+		uint32_t texture_mask = 0; // Bit per texture id, 0 for any
+		real_t texture_threshold = .5f;
+		int navigation = 0; // 0 any, 1 only navigable, 2 not navigable
+		real_t mesh_height_offset = 0.f;
+		int region_size = 0;
+		real_t vertex_spacing = 1.f;
+	};
+	ScatterJob _scatter;
+
+	// Physics bodies giving collision to instances near the targets, see _update_collision()
+	// Bodies are recycled through the pool instead of being freed as targets move
+	struct CollisionBody {
+		RID body;
+		RID shape; // Replaced when the mesh asset rebuilds its collision shape
+		Transform3D xform;
+		bool used = false;
+	};
+	HashMap<int64_t, CollisionBody> _collision_bodies; // By instance handle
+	LocalVector<RID> _collision_pool; // Unused bodies, outside of the physics space
+	LocalVector<uint64_t> _collision_targets; // Node3D instance ids. Uses the camera if empty
+	LocalVector<Vector3> _collision_positions; // Of the targets at the last update
+	bool _collision_dirty = true;
 
 	uint32_t _instance_counter = 0;
 	int _get_instace_count(const real_t p_density);
+	int _get_instance_count(const Ref<MultiMesh> &p_mm) const;
+	void _write_instance(real_t *p_dst, const Transform3D &p_xform, const Color &p_color) const;
+	void _fill_spare_instances(real_t *p_buffer, const int p_count, const int p_capacity) const;
+	int64_t _make_handle(const int p_mesh_id, const int p_region_index, const int p_cell_index, const int p_instance) const;
+	Vector2i _get_cell(const Vector3 &p_global_position, const int p_region_size) const;
+	void _find_cells(const Rect2 &p_rect, const int p_mesh_id, LocalVector<CellRef> &r_cells) const;
+	InstanceParams _get_instance_params(const Dictionary &p_params) const;
+	void _randomize_instance(const InstanceParams &p_params, const Vector3 &p_position, const Vector3 &p_normal,
+			uint32_t &p_state, Transform3D &r_xform, Color &r_color) const;
+	real_t _get_scatter_height(const ScatterTile &p_tile, const Vector3 &p_global_position) const;
+	void _scatter_tile(const uint32_t p_index);
+	Dictionary _query_instances(const AABB &p_area, const real_t p_radius, const int64_t p_mesh_mask) const;
 
 	void _update_mmis(const Vector2i &p_region_loc = V2I_MAX, const int p_mesh_id = -1);
+	void _update_mmi_by_cell(const Vector2i &p_region_loc, const int p_mesh_id, const Vector2i &p_cell);
+	void _update_lods(const Vector2i &p_region_loc, const int p_mesh_id, const Vector2i &p_cell);
+	void _copy_lod_multimesh(const Ref<MultiMesh> &p_src, const RID &p_dst) const;
+	void _free_cell_instances(CellInstances &p_cell_instances) const;
+	void _update_instance_settings();
+	void _update_collision();
+	void _destroy_collision();
 	void _destroy_mmi_by_location(const Vector2i &p_region_loc, const int p_mesh_id);
+	void _destroy_mmi_by_cell(const Vector2i &p_region_loc, const int p_mesh_id, const Vector2i &p_cell);
+	void _upgrade_multimesh(const Ref<Terrain3DRegion> &p_region, const int p_mesh_id);
+	void _append_region(const Ref<Terrain3DRegion> &p_region, const int p_mesh_id, const Transform3D *p_xforms,
+			const Color *p_colors, const uint32_t p_count, const bool p_clear);
+	void _append_cell(const Ref<Terrain3DRegion> &p_region, const int p_mesh_id, const Vector2i &p_cell,
+			const Transform3D *p_xforms, const Color *p_colors, const int p_count, const bool p_clear);
+	void _compact_cell(const Ref<Terrain3DRegion> &p_region, const int p_mesh_id, const Vector2i &p_cell,
+			PackedRealArray &p_buffer, const int p_count);
+	void _add_transforms(const int p_mesh_id, LocalVector<Transform3D> &p_xforms, const LocalVector<Color> &p_colors);
 	void _backup_regionl(const Vector2i &p_region_loc);
 	void _backup_region(const Ref<Terrain3DRegion> &p_region);
 
@@ -48,20 +189,31 @@ public:
 	void remove_instances(const Vector3 &p_global_position, const Dictionary &p_params);
 	void add_multimesh(const int p_mesh_id, const Ref<MultiMesh> &p_multimesh, const Transform3D &p_xform = Transform3D());
 	void add_transforms(const int p_mesh_id, const TypedArray<Transform3D> &p_xforms, const TypedArray<Color> &p_colors = TypedArray<Color>());
+	void add_instances_buffer(const int p_mesh_id, const PackedFloat32Array &p_xforms, const PackedColorArray &p_colors = PackedColorArray());
 	void append_multimesh(const Vector2i &p_region_loc, const int p_mesh_id, const TypedArray<Transform3D> &p_xforms, const TypedArray<Color> &p_colors, const bool p_clear = false);
 	void update_transforms(const AABB &p_aabb);
+	void scatter(const int p_mesh_id, const AABB &p_area, const Dictionary &p_rules);
+	Dictionary query_instances(const AABB &p_area, const int64_t p_mesh_mask = -1) const;
+	Dictionary query_instances_radius(const Vector3 &p_center, const real_t p_radius, const int64_t p_mesh_mask = -1) const;
+	void remove_instances_by_handle(const PackedInt64Array &p_handles);
 
 	void swap_ids(const int p_src_id, const int p_dst_id);
 	Ref<MultiMesh> get_multimeshp(const Vector3 &p_global_position, const int p_mesh_id) const;
-	Ref<MultiMesh> get_multimesh(const Vector2i &p_region_loc, const int p_mesh_id) const;
-	MultiMeshInstance3D *get_multimesh_instancep(const Vector3 &p_global_position, const int p_mesh_id) const;
-	MultiMeshInstance3D *get_multimesh_instance(const Vector2i &p_region_loc, const int p_mesh_id) const;
-	Dictionary get_mmis() const { return _mmis; }
+	Ref<MultiMesh> get_multimesh(const Vector2i &p_region_loc, const int p_mesh_id, const Vector2i &p_cell) const;
+	Ref<MultiMesh> get_multimesh(const Vector2i &p_region_loc, const int p_mesh_id) const; // Deprecated
+	RID get_instance_rid(const Vector2i &p_region_loc, const int p_mesh_id, const Vector2i &p_cell, const int p_lod = 0) const;
+	MultiMeshInstance3D *get_multimesh_instancep(const Vector3 &p_global_position, const int p_mesh_id) const; // Deprecated
+	MultiMeshInstance3D *get_multimesh_instance(const Vector2i &p_region_loc, const int p_mesh_id) const; // Deprecated
+	PackedFloat32Array get_instances_buffer(const Vector2i &p_region_loc, const int p_mesh_id) const;
+	PackedColorArray get_instances_colors(const Vector2i &p_region_loc, const int p_mesh_id) const;
+	Dictionary get_mmis() const;
 	void set_cast_shadows(const int p_mesh_id, const GeometryInstance3D::ShadowCastingSetting p_cast_shadows);
 	void force_update_mmis();
+	void add_collision_target(Node3D *p_target);
+	void remove_collision_target(Node3D *p_target);
 
 	void reset_instance_counter() { _instance_counter = 0; }
-	void print_multimesh_buffer(MultiMeshInstance3D *p_mmi) const;
+	void print_multimesh_buffer(const Ref<MultiMesh> &p_mm) const;
 
 protected:
 	static void _bind_methods();
@@ -79,4 +231,43 @@ inline int Terrain3DInstancer::_get_instace_count(const real_t p_density) {
 	return count;
 }
 
+// Multimeshes may have spare capacity beyond the visible instances. Returns the instances in use.
+inline int Terrain3DInstancer::_get_instance_count(const Ref<MultiMesh> &p_mm) const {
+	if (p_mm.is_null()) {
+		return 0;
+	}
+	int visible = p_mm->get_visible_instance_count();
+	return (visible < 0) ? p_mm->get_instance_count() : MIN(visible, p_mm->get_instance_count());
+}
+
+// Writes one instance into a MultiMesh buffer w/ TRANSFORM_3D and colors, MM_STRIDE floats
+inline void Terrain3DInstancer::_write_instance(real_t *p_dst, const Transform3D &p_xform, const Color &p_color) const {
+	for (int r = 0; r < 3; r++) {
+		p_dst[r * 4 + 0] = p_xform.basis.rows[r].x;
+		p_dst[r * 4 + 1] = p_xform.basis.rows[r].y;
+		p_dst[r * 4 + 2] = p_xform.basis.rows[r].z;
+		p_dst[r * 4 + 3] = p_xform.origin[r];
+	}
+	p_dst[12] = p_color.r;
+	p_dst[13] = p_color.g;
+	p_dst[14] = p_color.b;
+	p_dst[15] = p_color.a;
+}
+
+// Spare capacity repeats the first instance so it doesn't widen the MultiMesh AABB
+inline void Terrain3DInstancer::_fill_spare_instances(real_t *p_buffer, const int p_count, const int p_capacity) const {
+	for (int i = p_count; i < p_capacity; i++) {
+		memcpy(p_buffer + i * MM_STRIDE, p_buffer, MM_STRIDE * sizeof(real_t));
+	}
+}
+
+// Identifies an instance until its cell is edited, see query_instances()
+inline int64_t Terrain3DInstancer::_make_handle(const int p_mesh_id, const int p_region_index, const int p_cell_index, const int p_instance) const {
+	ERR_FAIL_COND_V(p_instance < 0 || p_instance >= MAX_CELL_INSTANCES, -1);
+	int64_t handle = int64_t(p_mesh_id) << (HANDLE_REGION_BITS + HANDLE_CELL_BITS + HANDLE_INSTANCE_BITS);
+	handle |= int64_t(p_region_index) << (HANDLE_CELL_BITS + HANDLE_INSTANCE_BITS);
+	handle |= int64_t(p_cell_index) << HANDLE_INSTANCE_BITS;
+	return handle | int64_t(p_instance);
+}
+
 #endif // TERRAIN3D_INSTANCER_CLASS_H
\ No newline at end of file
@@ -25,6 +25,7 @@ void Terrain3DMeshAsset::_set_generated_type(const GenType p_type) {
 		_meshes.clear();
 		LOG(DEBUG, "Generating card mesh");
 		_meshes.push_back(_get_generated_mesh());
+		_collision_shape.unref();
 		_set_material_override(_get_material());
 		_height_offset = 0.5f;
 		_generated_faces = 2;
@@ -42,14 +43,17 @@ void Terrain3DMeshAsset::_set_material_override(const Ref<Material> &p_material)
 		set_scene_file(_packed_scene);
 		return;
 	}
-	if (_material_override.is_valid() && _meshes.size() > 0) {
-		Ref<Mesh> mesh = _meshes[0];
-		if (mesh.is_null()) {
-			return;
-		}
-		LOG(DEBUG, "Setting material for ", mesh->get_surface_count(), " surfaces");
-		for (int i = 0; i < mesh->get_surface_count(); i++) {
-			mesh->surface_set_material(i, _material_override);
+	if (_material_override.is_valid()) {
+		// Applied to all LODs
+		for (int m = 0; m < _meshes.size(); m++) {
+			Ref<Mesh> mesh = _meshes[m];
+			if (mesh.is_null()) {
+				continue;
+			}
+			LOG(DEBUG, "Setting material for ", mesh->get_surface_count(), " surfaces of mesh ", m);
+			for (int i = 0; i < mesh->get_surface_count(); i++) {
+				mesh->surface_set_material(i, _material_override);
+			}
 		}
 	}
 }
@@ -157,6 +161,10 @@ void Terrain3DMeshAsset::clear() {
 	_generated_size = Vector2(1.f, 1.f);
 	_relative_density = -1.f;
 	_calculated_density = -1.f;
+	_lod_ranges.clear();
+	_last_shadow_lod = -1;
+	_collision_enabled = false;
+	_collision_radius = 20.f;
 	_packed_scene.unref();
 	_material_override.unref();
 	_set_generated_type(TYPE_TEXTURE_CARD);
@@ -205,6 +213,73 @@ void Terrain3DMeshAsset::set_cast_shadows(const GeometryInstance3D::ShadowCastin
 	emit_signal("cast_shadows_changed", _id, _cast_shadows);
 }
 
+// Sets the distance at which each LOD stops drawing. Each range must be beyond the previous one.
+// Zero on the last LOD draws it at any distance.
+void Terrain3DMeshAsset::set_lod_ranges(const PackedFloat32Array &p_ranges) {
+	_lod_ranges = p_ranges;
+	for (int i = 0; i < _lod_ranges.size(); i++) {
+		real_t previous = (i > 0) ? _lod_ranges[i - 1] : 0.f;
+		bool is_last = (i == _lod_ranges.size() - 1);
+		if (_lod_ranges[i] <= previous && !(is_last && _lod_ranges[i] == 0.f)) {
+			_lod_ranges[i] = previous + 1.f;
+		}
+	}
+	LOG(INFO, "Setting LOD ranges: ", _lod_ranges);
+	LOG(DEBUG, "Emitting setting_changed");
+	emit_signal("setting_changed");
+}
+
+void Terrain3DMeshAsset::set_last_shadow_lod(const int p_lod) {
+	_last_shadow_lod = MAX(-1, p_lod);
+	LOG(INFO, "Setting last shadow LOD: ", _last_shadow_lod);
+	emit_signal("cast_shadows_changed", _id, _cast_shadows);
+}
+
+// Each mesh in the scene file is a LOD, but only those w/ a range are used. Without ranges, only LOD0 is drawn
+int Terrain3DMeshAsset::get_lod_count() const {
+	return MAX(1, MIN(_lod_ranges.size(), _meshes.size()));
+}
+
+// Returns the visibility range begin and end of a LOD. An end of zero is unlimited
+Vector2 Terrain3DMeshAsset::get_lod_range(const int p_lod) const {
+	if (p_lod < 0 || p_lod >= get_lod_count() || _lod_ranges.is_empty()) {
+		return Vector2();
+	}
+	real_t begin = (p_lod > 0) ? _lod_ranges[p_lod - 1] : 0.f;
+	return Vector2(begin, _lod_ranges[p_lod]);
+}
+
+GeometryInstance3D::ShadowCastingSetting Terrain3DMeshAsset::get_lod_cast_shadows(const int p_lod) const {
+	if (_last_shadow_lod >= 0 && p_lod > _last_shadow_lod) {
+		return GeometryInstance3D::SHADOW_CASTING_SETTING_OFF;
+	}
+	return _cast_shadows;
+}
+
+void Terrain3DMeshAsset::set_collision_enabled(const bool p_enabled) {
+	_collision_enabled = p_enabled;
+	LOG(INFO, "Setting collision enabled: ", _collision_enabled);
+	emit_signal("setting_changed");
+}
+
+void Terrain3DMeshAsset::set_collision_radius(const real_t p_radius) {
+	_collision_radius = CLAMP(p_radius, 1.f, 1000.f);
+	LOG(INFO, "Setting collision radius: ", _collision_radius);
+	emit_signal("setting_changed");
+}
+
+// Returns a convex shape of LOD0, shared by all instances w/ collision
+Ref<Shape3D> Terrain3DMeshAsset::get_collision_shape() {
+	if (_collision_shape.is_null()) {
+		Ref<Mesh> mesh = get_mesh(0);
+		if (mesh.is_valid()) {
+			LOG(DEBUG, "Building convex collision shape for ", _name);
+			_collision_shape = mesh->create_convex_shape(true, false);
+		}
+	}
+	return _collision_shape;
+}
+
 void Terrain3DMeshAsset::set_scene_file(const Ref<PackedScene> &p_scene_file) {
 	LOG(INFO, "Setting scene file and instantiating node: ", p_scene_file);
 	_packed_scene = p_scene_file;
@@ -224,6 +299,7 @@ void Terrain3DMeshAsset::set_scene_file(const Ref<PackedScene> &p_scene_file) {
 		LOG(DEBUG, "Loaded scene with parent node: ", node);
 		TypedArray<Node> mesh_instances = node->find_children("*", "MeshInstance3D");
 		_meshes.clear();
+		_collision_shape.unref();
 		for (int i = 0; i < mesh_instances.size(); i++) {
 			MeshInstance3D *mi = cast_to<MeshInstance3D>(mesh_instances[i]);
 			LOG(DEBUG, "Found mesh: ", mi->get_name());
@@ -277,6 +353,7 @@ void Terrain3DMeshAsset::set_generated_faces(const int p_count) {
 		LOG(INFO, "Setting generated face count: ", _generated_faces);
 		if (_generated_type > TYPE_NONE && _generated_type < TYPE_MAX && _meshes.size() == 1) {
 			_meshes[0] = _get_generated_mesh();
+			_collision_shape.unref();
 			_set_material_override(_get_material());
 			LOG(DEBUG, "Emitting setting_changed");
 			emit_signal("setting_changed");
@@ -290,6 +367,7 @@ void Terrain3DMeshAsset::set_generated_size(const Vector2 &p_size) {
 		LOG(INFO, "Setting generated size: ", _generated_faces);
 		if (_generated_type > TYPE_NONE && _generated_type < TYPE_MAX && _meshes.size() == 1) {
 			_meshes[0] = _get_generated_mesh();
+			_collision_shape.unref();
 			_set_material_override(_get_material());
 			LOG(DEBUG, "Emitting setting_changed");
 			emit_signal("setting_changed");
@@ -340,6 +418,17 @@ void Terrain3DMeshAsset::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("get_density"), &Terrain3DMeshAsset::get_density);
 	ClassDB::bind_method(D_METHOD("set_cast_shadows", "mode"), &Terrain3DMeshAsset::set_cast_shadows);
 	ClassDB::bind_method(D_METHOD("get_cast_shadows"), &Terrain3DMeshAsset::get_cast_shadows);
+	ClassDB::bind_method(D_METHOD("set_lod_ranges", "ranges"), &Terrain3DMeshAsset::set_lod_ranges);
+	ClassDB::bind_method(D_METHOD("get_lod_ranges"), &Terrain3DMeshAsset::get_lod_ranges);
+	ClassDB::bind_method(D_METHOD("set_last_shadow_lod", "lod"), &Terrain3DMeshAsset::set_last_shadow_lod);
+	ClassDB::bind_method(D_METHOD("get_last_shadow_lod"), &Terrain3DMeshAsset::get_last_shadow_lod);
+	ClassDB::bind_method(D_METHOD("get_lod_count"), &Terrain3DMeshAsset::get_lod_count);
+	ClassDB::bind_method(D_METHOD("get_lod_range", "lod"), &Terrain3DMeshAsset::get_lod_range);
+	ClassDB::bind_method(D_METHOD("set_collision_enabled", "enabled"), &Terrain3DMeshAsset::set_collision_enabled);
+	ClassDB::bind_method(D_METHOD("get_collision_enabled"), &Terrain3DMeshAsset::get_collision_enabled);
+	ClassDB::bind_method(D_METHOD("set_collision_radius", "radius"), &Terrain3DMeshAsset::set_collision_radius);
+	ClassDB::bind_method(D_METHOD("get_collision_radius"), &Terrain3DMeshAsset::get_collision_radius);
+	ClassDB::bind_method(D_METHOD("get_collision_shape"), &Terrain3DMeshAsset::get_collision_shape);
 	ClassDB::bind_method(D_METHOD("set_scene_file", "scene_file"), &Terrain3DMeshAsset::set_scene_file);
 	ClassDB::bind_method(D_METHOD("get_scene_file"), &Terrain3DMeshAsset::get_scene_file);
 	ClassDB::bind_method(D_METHOD("set_material_override", "material"), &Terrain3DMeshAsset::set_material_override);
@@ -359,6 +448,10 @@ void Terrain3DMeshAsset::_bind_methods() {
 	ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "height_offset", PROPERTY_HINT_RANGE, "-20.0,20.0,.005"), "set_height_offset", "get_height_offset");
 	ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "density", PROPERTY_HINT_RANGE, ".01,10.0,.005"), "set_density", "get_density");
 	ADD_PROPERTY(PropertyInfo(Variant::INT, "cast_shadows", PROPERTY_HINT_ENUM, "Off,On,Double-Sided,Shadows Only"), "set_cast_shadows", "get_cast_shadows");
+	ADD_PROPERTY(PropertyInfo(Variant::PACKED_FLOAT32_ARRAY, "lod_ranges", PROPERTY_HINT_NONE), "set_lod_ranges", "get_lod_ranges");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "last_shadow_lod", PROPERTY_HINT_RANGE, "-1,9,1"), "set_last_shadow_lod", "get_last_shadow_lod");
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "collision_enabled", PROPERTY_HINT_NONE), "set_collision_enabled", "get_collision_enabled");
+	ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "collision_radius", PROPERTY_HINT_RANGE, "1.0,1000.0,0.5"), "set_collision_radius", "get_collision_radius");
 	ADD_PROPERTY(PropertyInfo(Variant::OBJECT, "scene_file", PROPERTY_HINT_RESOURCE_TYPE, "PackedScene"), "set_scene_file", "get_scene_file");
 	ADD_PROPERTY(PropertyInfo(Variant::OBJECT, "material_override", PROPERTY_HINT_RESOURCE_TYPE, "BaseMaterial3D,ShaderMaterial"), "set_material_override", "get_material_override");
 	ADD_PROPERTY(PropertyInfo(Variant::INT, "generated_type", PROPERTY_HINT_ENUM, "None,Texture Card"), "set_generated_type", "get_generated_type");
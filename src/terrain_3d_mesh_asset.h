@@ -7,6 +7,7 @@
 #include <godot_cpp/classes/material.hpp>
 #include <godot_cpp/classes/packed_scene.hpp>
 #include <godot_cpp/classes/resource.hpp>
+#include <godot_cpp/classes/shape3d.hpp>
 #include <godot_cpp/classes/texture2d.hpp>
 
 #include "constants.h"
@@ -37,10 +38,15 @@ private:
 	Ref<Material> _material_override;
 	real_t _relative_density = -1.f;
 	real_t _calculated_density = -1.f;
+	PackedFloat32Array _lod_ranges;
+	int _last_shadow_lod = -1;
+	bool _collision_enabled = false;
+	real_t _collision_radius = 20.f;
 
 	// Working data
 	TypedArray<Mesh> _meshes;
 	Ref<Texture2D> _thumbnail;
+	Ref<Shape3D> _collision_shape; // Built from LOD0 on demand
 
 	// No signal versions
 	void _set_generated_type(const GenType p_type);
@@ -67,6 +73,19 @@ public:
 
 	void set_cast_shadows(const GeometryInstance3D::ShadowCastingSetting p_cast_shadows);
 	GeometryInstance3D::ShadowCastingSetting get_cast_shadows() const { return _cast_shadows; };
+	void set_lod_ranges(const PackedFloat32Array &p_ranges);
+	PackedFloat32Array get_lod_ranges() const { return _lod_ranges; }
+	void set_last_shadow_lod(const int p_lod);
+	int get_last_shadow_lod() const { return _last_shadow_lod; }
+	int get_lod_count() const;
+	Vector2 get_lod_range(const int p_lod) const;
+	GeometryInstance3D::ShadowCastingSetting get_lod_cast_shadows(const int p_lod) const;
+
+	void set_collision_enabled(const bool p_enabled);
+	bool get_collision_enabled() const { return _collision_enabled; }
+	void set_collision_radius(const real_t p_radius);
+	real_t get_collision_radius() const { return _collision_radius; }
+	Ref<Shape3D> get_collision_shape();
 
 	void set_scene_file(const Ref<PackedScene> &p_scene_file);
 	Ref<PackedScene> get_scene_file() const { return _packed_scene; }
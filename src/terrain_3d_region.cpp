@@ -7,6 +7,344 @@
 #include "terrain_3d_region.h"
 #include "terrain_3d_util.h"
 
+/////////////////////
+// Private Functions
+/////////////////////
+
+// Returns the bytes to store for a raw chunk, compressed if smaller, and fills in its sizes
+PackedByteArray Terrain3DRegion::_compress_raw_chunk(const PackedByteArray &p_data, const int p_compression, RawChunk &r_chunk) {
+	r_chunk.size = p_data.size();
+	r_chunk.stored_size = p_data.size();
+	if (p_compression == RAW_UNCOMPRESSED || p_data.is_empty()) {
+		return p_data;
+	}
+	PackedByteArray compressed = p_data.compress(FileAccess::CompressionMode(p_compression));
+	if (compressed.is_empty() || compressed.size() >= p_data.size()) {
+		return p_data;
+	}
+	r_chunk.stored_size = compressed.size();
+	return compressed;
+}
+
+// Returns the file layout of this region for save_raw(), with no chunks placed yet
+Terrain3DRegion::RawHeader Terrain3DRegion::_get_raw_layout(const bool p_16_bit, const int p_compression) const {
+	RawHeader header;
+	header.version = Terrain3DData::CURRENT_VERSION;
+	header.region_size = _region_size;
+	header.location = _location;
+	header.height_range = _height_range;
+	header.chunk_size = MIN(RAW_CHUNK_SIZE, _region_size);
+	header.compression = p_compression;
+	const int chunks_per_side = _region_size / header.chunk_size;
+	const Ref<Image> maps[TYPE_MAX] = { _height_map, _control_map, _color_map };
+	uint32_t count = 0;
+	for (int i = 0; i < TYPE_MAX; i++) {
+		// Blank maps are left out, and refilled by sanitize_maps() on load
+		if (maps[i].is_null() || maps[i]->get_width() != _region_size || is_blank(MapType(i))) {
+			continue;
+		}
+		RawPlane &plane = header.planes[i];
+		plane.format = maps[i]->get_format();
+		if (i == TYPE_HEIGHT && p_16_bit && plane.format == Image::FORMAT_RF) {
+			plane.format = Image::FORMAT_RH;
+		}
+		plane.mipmaps = maps[i]->has_mipmaps();
+		plane.first_chunk = count;
+		plane.chunk_count = chunks_per_side * chunks_per_side + (plane.mipmaps ? 1 : 0);
+		count += plane.chunk_count;
+	}
+	header.planes[TYPE_MAX].first_chunk = count;
+	header.planes[TYPE_MAX].chunk_count = 1;
+	header.chunks.resize(count + 1);
+	return header;
+}
+
+// Returns the stored bytes of one chunk of a plane in the layout from _get_raw_layout(), and fills in
+// its sizes and height range. Index chunks_per_side^2 is the mipmaps. p_map_data is the map's data.
+PackedByteArray Terrain3DRegion::_get_raw_chunk(const RawHeader &p_header, const int p_plane, const uint32_t p_index, const PackedByteArray &p_map_data, RawChunk &r_chunk) const {
+	r_chunk = RawChunk();
+	if (p_plane == TYPE_MAX) {
+		return _compress_raw_chunk(get_instances(), p_header.compression, r_chunk);
+	}
+	const Ref<Image> map = get_map(MapType(p_plane));
+	const int region_size = _region_size;
+	const int chunk_size = p_header.chunk_size;
+	const int chunks_per_side = region_size / chunk_size;
+	const int64_t level_size = map->has_mipmaps() ? map->get_mipmap_offset(1) : p_map_data.size();
+	if (p_index >= uint32_t(chunks_per_side * chunks_per_side)) {
+		return _compress_raw_chunk(p_map_data.slice(level_size), p_header.compression, r_chunk);
+	}
+	const int64_t pixel_size = level_size / (int64_t(region_size) * region_size);
+	const bool is_height = p_plane == TYPE_HEIGHT;
+	const bool half = is_height && is_half_height(map);
+	const bool to_half = is_height && !half && p_header.planes[p_plane].format == Image::FORMAT_RH;
+	const int64_t row_size = chunk_size * (to_half ? 2 : pixel_size);
+	const Vector2i origin = Vector2i(p_index % chunks_per_side, p_index / chunks_per_side) * chunk_size;
+	PackedByteArray bytes;
+	bytes.resize(row_size * chunk_size);
+	uint8_t *dst = bytes.ptrw();
+	Vector2 range = Vector2(FLT_MAX, -FLT_MAX);
+	for (int y = 0; y < chunk_size; y++) {
+		const uint8_t *src = p_map_data.ptr() + (int64_t(origin.y + y) * region_size + origin.x) * pixel_size;
+		uint8_t *dst_row = dst + y * row_size;
+		if (!to_half) {
+			memcpy(dst_row, src, row_size);
+		}
+		if (!is_height) {
+			continue;
+		}
+		for (int x = 0; x < chunk_size; x++) {
+			float height = get_height_value(src, half, x);
+			if (to_half) {
+				uint16_t half = Math::make_half_float(height);
+				memcpy(dst_row + x * sizeof(uint16_t), &half, sizeof(uint16_t));
+			}
+			if (!std::isnan(height)) {
+				range.x = MIN(range.x, height);
+				range.y = MAX(range.y, height);
+			}
+		}
+	}
+	if (range.x <= range.y) {
+		r_chunk.height_range = range;
+	}
+	return _compress_raw_chunk(bytes, p_header.compression, r_chunk);
+}
+
+// Returns the header and chunk index of a raw region file, which save_raw() stores after the chunks
+PackedByteArray Terrain3DRegion::_get_raw_header(const RawHeader &p_header) {
+	LocalVector<uint8_t> out;
+	write_bytes(out, float(p_header.version));
+	write_bytes(out, uint32_t(p_header.region_size));
+	write_bytes(out, int32_t(p_header.location.x));
+	write_bytes(out, int32_t(p_header.location.y));
+	write_bytes(out, float(p_header.height_range.x));
+	write_bytes(out, float(p_header.height_range.y));
+	write_bytes(out, uint32_t(p_header.chunk_size));
+	write_bytes(out, int32_t(p_header.compression));
+	for (const RawPlane &plane : p_header.planes) {
+		write_bytes(out, uint32_t(plane.chunk_count > 0 ? plane.format : 0));
+		write_bytes(out, uint32_t(plane.mipmaps));
+		write_bytes(out, plane.first_chunk);
+		write_bytes(out, plane.chunk_count);
+	}
+	write_bytes(out, uint32_t(p_header.chunks.size()));
+	for (const RawChunk &chunk : p_header.chunks) {
+		write_bytes(out, chunk.offset);
+		write_bytes(out, chunk.stored_size);
+		write_bytes(out, chunk.size);
+		write_bytes(out, float(chunk.height_range.x));
+		write_bytes(out, float(chunk.height_range.y));
+	}
+	PackedByteArray data;
+	data.resize(out.size());
+	memcpy(data.ptrw(), out.ptr(), out.size());
+	return data;
+}
+
+// Writes chunks starting at p_offset, the end of the file, and records where each was placed.
+// Uncompressed files keep every chunk page aligned.
+Error Terrain3DRegion::_write_raw_chunks(const Ref<FileAccess> &p_file, RawHeader &r_header, const LocalVector<uint32_t> &p_indices, const LocalVector<PackedByteArray> &p_data, uint64_t p_offset) {
+	PackedByteArray padding;
+	padding.resize(RAW_PAGE_SIZE);
+	padding.fill(0);
+	p_file->seek(p_offset);
+	for (uint32_t i = 0; i < p_indices.size(); i++) {
+		uint64_t aligned = (p_offset + RAW_PAGE_SIZE - 1) / RAW_PAGE_SIZE * RAW_PAGE_SIZE;
+		if (r_header.compression == RAW_UNCOMPRESSED && aligned > p_offset) {
+			p_file->store_buffer(padding.slice(0, aligned - p_offset));
+			p_offset = aligned;
+		}
+		r_header.chunks[p_indices[i]].offset = p_offset;
+		p_file->store_buffer(p_data[i]);
+		p_offset += p_data[i].size();
+	}
+	return p_file->get_error();
+}
+
+// Appends the header and index to the file, then points the prefix at it. The prefix is rewritten
+// last, and fits in one disk sector, so an interrupted save leaves the previous index in use.
+Error Terrain3DRegion::_write_raw_index(const Ref<FileAccess> &p_file, const RawHeader &p_header) {
+	p_file->flush();
+	uint64_t offset = p_file->get_length();
+	PackedByteArray index = _get_raw_header(p_header);
+	p_file->seek(offset);
+	p_file->store_buffer(index);
+	p_file->flush();
+	if (p_file->get_error() != OK) {
+		return p_file->get_error();
+	}
+	LocalVector<uint8_t> out;
+	write_bytes(out, RAW_MAGIC);
+	write_bytes(out, RAW_FORMAT);
+	write_bytes(out, offset);
+	write_bytes(out, uint32_t(index.size()));
+	PackedByteArray prefix;
+	prefix.resize(out.size());
+	memcpy(prefix.ptrw(), out.ptr(), out.size());
+	p_file->seek(0);
+	p_file->store_buffer(prefix);
+	p_file->flush();
+	return p_file->get_error();
+}
+
+// Reads and validates the header and chunk index of a raw region file
+Error Terrain3DRegion::_read_raw_header(const Ref<FileAccess> &p_file, RawHeader &r_header) {
+	p_file->seek(0);
+	PackedByteArray buffer = p_file->get_buffer(RAW_PREFIX_SIZE);
+	const uint8_t *src = buffer.ptr();
+	int64_t size = buffer.size();
+	int64_t pos = 0;
+	uint32_t magic = 0;
+	uint32_t format = 0;
+	uint64_t index_offset = 0;
+	uint32_t index_size = 0;
+	if (!read_bytes(src, size, pos, magic) || magic != RAW_MAGIC || !read_bytes(src, size, pos, format) || format != RAW_FORMAT) {
+		LOG(ERROR, "Not a raw region file, or unknown format ", format, ": ", p_file->get_path());
+		return ERR_FILE_UNRECOGNIZED;
+	}
+	uint64_t file_size = p_file->get_length();
+	if (!read_bytes(src, size, pos, index_offset) || !read_bytes(src, size, pos, index_size) ||
+			index_offset < uint64_t(RAW_PREFIX_SIZE) || index_offset + index_size > file_size) {
+		LOG(ERROR, "Region file index truncated: ", p_file->get_path());
+		return ERR_FILE_CORRUPT;
+	}
+	p_file->seek(index_offset);
+	buffer = p_file->get_buffer(index_size);
+	src = buffer.ptr();
+	size = buffer.size();
+	pos = 0;
+	float version = 0.f;
+	uint32_t region_size = 0;
+	int32_t loc_x = 0;
+	int32_t loc_y = 0;
+	float range_min = 0.f;
+	float range_max = 0.f;
+	uint32_t chunk_size = 0;
+	int32_t compression = RAW_UNCOMPRESSED;
+	if (!read_bytes(src, size, pos, version) || !read_bytes(src, size, pos, region_size) ||
+			!read_bytes(src, size, pos, loc_x) || !read_bytes(src, size, pos, loc_y) ||
+			!read_bytes(src, size, pos, range_min) || !read_bytes(src, size, pos, range_max) ||
+			!read_bytes(src, size, pos, chunk_size) || !read_bytes(src, size, pos, compression)) {
+		LOG(ERROR, "Region file header truncated: ", p_file->get_path());
+		return ERR_FILE_CORRUPT;
+	}
+	if (!is_power_of_2(region_size) || region_size < 64 || region_size > 2048 ||
+			chunk_size == 0 || chunk_size > region_size || region_size % chunk_size != 0) {
+		LOG(ERROR, "Invalid region size ", region_size, " or chunk size ", chunk_size, " in ", p_file->get_path());
+		return ERR_FILE_CORRUPT;
+	}
+	r_header.version = version;
+	r_header.region_size = region_size;
+	r_header.location = Vector2i(loc_x, loc_y);
+	r_header.height_range = Vector2(range_min, range_max);
+	r_header.chunk_size = chunk_size;
+	r_header.compression = compression;
+	for (RawPlane &plane : r_header.planes) {
+		uint32_t image_format = 0;
+		uint32_t mipmaps = 0;
+		if (!read_bytes(src, size, pos, image_format) || !read_bytes(src, size, pos, mipmaps) ||
+				!read_bytes(src, size, pos, plane.first_chunk) || !read_bytes(src, size, pos, plane.chunk_count) ||
+				image_format >= Image::FORMAT_MAX) {
+			LOG(ERROR, "Region file header truncated: ", p_file->get_path());
+			return ERR_FILE_CORRUPT;
+		}
+		plane.format = Image::Format(image_format);
+		plane.mipmaps = mipmaps != 0;
+	}
+
+	uint32_t chunk_count = 0;
+	if (!read_bytes(src, size, pos, chunk_count) || size - pos < int64_t(chunk_count) * 24) {
+		LOG(ERROR, "Region file index truncated: ", p_file->get_path());
+		return ERR_FILE_CORRUPT;
+	}
+	r_header.chunks.resize(chunk_count);
+	for (RawChunk &chunk : r_header.chunks) {
+		float min = 0.f;
+		float max = 0.f;
+		if (!read_bytes(src, size, pos, chunk.offset) || !read_bytes(src, size, pos, chunk.stored_size) ||
+				!read_bytes(src, size, pos, chunk.size) || !read_bytes(src, size, pos, min) ||
+				!read_bytes(src, size, pos, max)) {
+			LOG(ERROR, "Region file index truncated: ", p_file->get_path());
+			return ERR_FILE_CORRUPT;
+		}
+		chunk.height_range = Vector2(min, max);
+		if (chunk.offset + chunk.stored_size > file_size || chunk.stored_size > chunk.size) {
+			LOG(ERROR, "Region file chunks truncated: ", p_file->get_path());
+			return ERR_FILE_CORRUPT;
+		}
+	}
+	for (const RawPlane &plane : r_header.planes) {
+		if (uint64_t(plane.first_chunk) + plane.chunk_count > chunk_count) {
+			LOG(ERROR, "Region file index invalid: ", p_file->get_path());
+			return ERR_FILE_CORRUPT;
+		}
+	}
+	return OK;
+}
+
+// Reads and decompresses one chunk
+bool Terrain3DRegion::_read_raw_chunk(const Ref<FileAccess> &p_file, const RawHeader &p_header, const uint32_t p_index, PackedByteArray &r_data) {
+	if (p_index >= p_header.chunks.size()) {
+		return false;
+	}
+	const RawChunk &chunk = p_header.chunks[p_index];
+	p_file->seek(chunk.offset);
+	r_data = p_file->get_buffer(chunk.stored_size);
+	if (chunk.stored_size < chunk.size) {
+		r_data = r_data.decompress(chunk.size, FileAccess::CompressionMode(p_header.compression));
+	}
+	return r_data.size() == chunk.size;
+}
+
+// Assembles a map from its chunks within p_chunks, in chunk coordinates. Other pixels are zero.
+// Mipmaps are included only if the whole map is read.
+Ref<Image> Terrain3DRegion::_read_raw_map(const Ref<FileAccess> &p_file, const RawHeader &p_header, const MapType p_map_type, const Rect2i &p_chunks) {
+	const RawPlane &plane = p_header.planes[p_map_type];
+	const int region_size = p_header.region_size;
+	const int chunk_size = p_header.chunk_size;
+	const int chunks_per_side = region_size / chunk_size;
+	if (plane.chunk_count < uint32_t(chunks_per_side * chunks_per_side)) {
+		return Ref<Image>();
+	}
+	const bool whole = p_chunks == Rect2i(0, 0, chunks_per_side, chunks_per_side);
+	const bool mipmaps = whole && plane.mipmaps && plane.chunk_count > uint32_t(chunks_per_side * chunks_per_side);
+	const int64_t pixel_size = p_header.chunks[plane.first_chunk].size / (int64_t(chunk_size) * chunk_size);
+	const int64_t row_size = chunk_size * pixel_size;
+	const int64_t level_size = int64_t(region_size) * region_size * pixel_size;
+	PackedByteArray data;
+	PackedByteArray tail;
+	if (mipmaps && !_read_raw_chunk(p_file, p_header, plane.first_chunk + chunks_per_side * chunks_per_side, tail)) {
+		return Ref<Image>();
+	}
+	data.resize(level_size + tail.size());
+	if (!whole) {
+		data.fill(0);
+	}
+	uint8_t *dst = data.ptrw();
+	PackedByteArray chunk_bytes;
+	for (int cy = p_chunks.position.y; cy < p_chunks.get_end().y; cy++) {
+		for (int cx = p_chunks.position.x; cx < p_chunks.get_end().x; cx++) {
+			uint32_t index = plane.first_chunk + cy * chunks_per_side + cx;
+			if (!_read_raw_chunk(p_file, p_header, index, chunk_bytes) || chunk_bytes.size() != row_size * chunk_size) {
+				return Ref<Image>();
+			}
+			for (int y = 0; y < chunk_size; y++) {
+				int64_t offset = ((int64_t(cy) * chunk_size + y) * region_size + cx * chunk_size) * pixel_size;
+				memcpy(dst + offset, chunk_bytes.ptr() + y * row_size, row_size);
+			}
+		}
+	}
+	if (mipmaps) {
+		memcpy(dst + level_size, tail.ptr(), tail.size());
+	}
+	Ref<Image> map = Image::create_from_data(region_size, region_size, mipmaps, plane.format, data);
+	if (map.is_null() || map->is_empty()) {
+		return Ref<Image>();
+	}
+	return map;
+}
+
 /////////////////////
 // Public Functions
 /////////////////////
@@ -80,6 +418,8 @@ void Terrain3DRegion::set_height_map(const Ref<Image> &p_map) {
 		set_region_size((p_map.is_valid()) ? p_map->get_width() : 0);
 	}
 	_height_map = sanitize_map(TYPE_HEIGHT, p_map);
+	_missing_maps &= ~(1 << TYPE_HEIGHT);
+	_dirty_all = true;
 	calc_height_range();
 }
 
@@ -89,6 +429,8 @@ void Terrain3DRegion::set_control_map(const Ref<Image> &p_map) {
 		set_region_size((p_map.is_valid()) ? p_map->get_width() : 0);
 	}
 	_control_map = sanitize_map(TYPE_CONTROL, p_map);
+	_missing_maps &= ~(1 << TYPE_CONTROL);
+	_dirty_all = true;
 }
 
 void Terrain3DRegion::set_color_map(const Ref<Image> &p_map) {
@@ -97,6 +439,8 @@ void Terrain3DRegion::set_color_map(const Ref<Image> &p_map) {
 		set_region_size((p_map.is_valid()) ? p_map->get_width() : 0);
 	}
 	_color_map = sanitize_map(TYPE_COLOR, p_map);
+	_missing_maps &= ~(1 << TYPE_COLOR);
+	_dirty_all = true;
 	if (!_color_map->has_mipmaps()) {
 		LOG(DEBUG, "Color map does not have mipmaps. Generating");
 		_color_map->generate_mipmaps();
@@ -121,7 +465,8 @@ Ref<Image> Terrain3DRegion::sanitize_map(const MapType p_map_type, const Ref<Ima
 
 	if (p_map.is_valid()) {
 		if (validate_map_size(p_map)) {
-			if (p_map->get_format() == format) {
+			// Height maps may also be kept as half floats, see Terrain3DData::get_height_format()
+			if (p_map->get_format() == format || (p_map_type == TYPE_HEIGHT && is_half_height(p_map))) {
 				LOG(DEBUG, "Map type ", type_str, " correct format, size. Mipmaps: ", p_map->has_mipmaps());
 				map = p_map;
 			} else {
@@ -148,6 +493,84 @@ Ref<Image> Terrain3DRegion::sanitize_map(const MapType p_map_type, const Ref<Ima
 	}
 }
 
+// Returns true if a map holds only its default value, as filled by sanitize_map(). Blank maps are
+// left out of saved files, and Terrain3DData shares one copy of their pixels between regions.
+bool Terrain3DRegion::is_blank(const MapType p_map_type) const {
+	if (p_map_type < 0 || p_map_type >= TYPE_MAX) {
+		return false;
+	}
+	Ref<Image> map = get_map(p_map_type);
+	if (map.is_null() || map->is_empty()) {
+		return false;
+	}
+	const PackedByteArray value = Util::get_filled_image(Vector2i(1, 1), COLOR[p_map_type], false, map->get_format())->get_data();
+	const PackedByteArray data = map->get_data();
+	const int64_t size = value.size();
+	if (size == 0 || data.size() < size || memcmp(data.ptr(), value.ptr(), size) != 0) {
+		return false;
+	}
+	// The first pixel is the default, and every pixel matches the one before it
+	return memcmp(data.ptr(), data.ptr() + size, data.size() - size) == 0;
+}
+
+// Frees maps a process doesn't need, replacing them with blanks until load_maps() reads them back
+// from the region file. Modified regions are kept, as their maps would be lost.
+void Terrain3DRegion::unload_maps(const int p_map_mask) {
+	int mask = p_map_mask & ALL_MAPS & ~_missing_maps;
+	if (mask == 0) {
+		return;
+	}
+	if (_modified || get_path().is_empty()) {
+		LOG(WARN, "Region ", _location, " has unsaved changes or no file. Keeping all maps");
+		return;
+	}
+	Ref<Image> *maps[TYPE_MAX] = { &_height_map, &_control_map, &_color_map };
+	for (int i = 0; i < TYPE_MAX; i++) {
+		if (mask & (1 << i)) {
+			LOG(DEBUG, "Unloading ", TYPESTR[i], " of region ", _location);
+			*maps[i] = sanitize_map(MapType(i), Ref<Image>());
+			_missing_maps |= 1 << i;
+		}
+	}
+}
+
+// Reads maps left out by unload_maps() or load_raw() from the region file. Replaces the Image of
+// each map read, so Terrain3DData regenerates its texture arrays on the next update.
+Error Terrain3DRegion::load_maps(const int p_map_mask) {
+	int mask = p_map_mask & _missing_maps;
+	if (mask == 0) {
+		return OK;
+	}
+	String path = get_path();
+	LOG(INFO, "Loading missing maps ", mask, " of region ", _location, " from ", path);
+	Ref<Terrain3DRegion> source;
+	if (path.get_extension() != RAW_EXTENSION) {
+		source = ResourceLoader::get_singleton()->load(path, "Terrain3DRegion", ResourceLoader::CACHE_MODE_IGNORE);
+		if (source.is_null()) {
+			LOG(ERROR, "Cannot load region file: ", path);
+			return ERR_FILE_CANT_READ;
+		}
+	}
+	Ref<Image> *maps[TYPE_MAX] = { &_height_map, &_control_map, &_color_map };
+	for (int i = 0; i < TYPE_MAX; i++) {
+		MapType type = MapType(i);
+		if (!(mask & (1 << i))) {
+			continue;
+		}
+		Ref<Image> map = source.is_valid() ? source->get_map(type) : load_raw_map(path, type);
+		if (map.is_null()) {
+			LOG(ERROR, "Cannot read ", TYPESTR[i], " from region file: ", path);
+			return ERR_FILE_CORRUPT;
+		}
+		*maps[i] = sanitize_map(type, map);
+		if (type == TYPE_COLOR && !_color_map->has_mipmaps()) {
+			_color_map->generate_mipmaps();
+		}
+		_missing_maps &= ~(1 << i);
+	}
+	return OK;
+}
+
 bool Terrain3DRegion::validate_map_size(const Ref<Image> &p_map) const {
 	Vector2i region_sizev = p_map->get_size();
 	if (region_sizev.x != region_sizev.y) {
@@ -193,7 +616,7 @@ void Terrain3DRegion::calc_height_range() {
 	}
 }
 
-Error Terrain3DRegion::save(const String &p_path, const bool p_16_bit) {
+Error Terrain3DRegion::save(const String &p_path, const bool p_16_bit, const int p_compression) {
 	// Initiate save to external file. The scene will save itself.
 	if (_location.x == INT32_MAX) {
 		LOG(ERROR, "Region has not been setup. Location is INT32_MAX. Skipping ", p_path);
@@ -206,6 +629,12 @@ Error Terrain3DRegion::save(const String &p_path, const bool p_16_bit) {
 		LOG(ERROR, "No valid path provided");
 		return ERR_FILE_NOT_FOUND;
 	}
+	// Maps left out by unload_maps() are read back first, so they aren't saved as blanks
+	Error err = load_maps();
+	if (err != OK) {
+		LOG(ERROR, "Cannot read unloaded maps of region ", _location, ". Skipping ", p_path);
+		return err;
+	}
 	if (get_path().is_empty() && !p_path.is_empty()) {
 		LOG(DEBUG, "Setting file path for region ", _location, " to ", p_path);
 		take_over_path(p_path);
@@ -214,19 +643,33 @@ Error Terrain3DRegion::save(const String &p_path, const bool p_16_bit) {
 	}
 	LOG(MESG, "Writing", (p_16_bit) ? " 16-bit" : "", " region ", _location, " to ", get_path());
 	set_version(Terrain3DData::CURRENT_VERSION);
-	Error err;
-	if (p_16_bit) {
-		Ref<Image> original_map;
-		original_map.instantiate();
-		original_map->copy_from(_height_map);
-		_height_map->convert(Image::FORMAT_RH);
-		err = ResourceSaver::get_singleton()->save(this, get_path(), ResourceSaver::FLAG_COMPRESS);
-		_height_map = original_map;
+	if (get_path().get_extension() == RAW_EXTENSION) {
+		err = update_raw(get_path(), p_16_bit, p_compression);
+		if (err == ERR_UNAVAILABLE) {
+			err = save_raw(get_path(), p_16_bit, p_compression);
+		}
 	} else {
+		// Blank maps are saved as null, and refilled by sanitize_maps() on load
+		Ref<Image> *maps[TYPE_MAX] = { &_height_map, &_control_map, &_color_map };
+		Ref<Image> original_maps[TYPE_MAX] = { _height_map, _control_map, _color_map };
+		for (int i = 0; i < TYPE_MAX; i++) {
+			if (is_blank(MapType(i))) {
+				maps[i]->unref();
+			}
+		}
+		if (p_16_bit && _height_map.is_valid()) {
+			_height_map.instantiate();
+			_height_map->copy_from(original_maps[TYPE_HEIGHT]);
+			_height_map->convert(Image::FORMAT_RH);
+		}
 		err = ResourceSaver::get_singleton()->save(this, get_path(), ResourceSaver::FLAG_COMPRESS);
+		for (int i = 0; i < TYPE_MAX; i++) {
+			*maps[i] = original_maps[i];
+		}
 	}
 	if (err == OK) {
 		_modified = false;
+		clear_dirty();
 		LOG(INFO, "File saved successfully");
 	} else {
 		LOG(ERROR, "Cannot save region file: ", get_path(), ". Error code: ", ERROR, ". Look up @GlobalScope Error enum in the Godot docs");
@@ -234,6 +677,532 @@ Error Terrain3DRegion::save(const String &p_path, const bool p_16_bit) {
 	return err;
 }
 
+/**
+ * Writes the region as independently readable chunks. Layout:
+ *   Prefix, padded to RAW_PAGE_SIZE:
+ *     uint32 RAW_MAGIC, uint32 RAW_FORMAT, uint64 header offset, uint32 header size
+ *   Chunks, from the first page
+ *   Header:
+ *     float version, uint32 region size,
+ *     int32 location x, int32 location y, float height range min, float height range max,
+ *     uint32 chunk size, int32 compression (RAW_UNCOMPRESSED or FileAccess::CompressionMode)
+ *     Per plane (height, control, color, instances): uint32 Image::Format, uint32 mipmaps,
+ *       uint32 first chunk, uint32 chunk count
+ *     uint32 chunk count, then per chunk: uint64 offset, uint32 stored size, uint32 size,
+ *       float height min, float height max
+ * Each map is split into RAW_CHUNK_SIZE squares, in rows, stored as Image::get_data() lays out
+ * pixels. Mipmaps follow as one chunk. Instances are one chunk, see get_instances().
+ * A chunk is compressed only if that makes it smaller. Uncompressed files keep every chunk page
+ * aligned, so they can be read without any decoding.
+ **/
+Error Terrain3DRegion::save_raw(const String &p_path, const bool p_16_bit, const int p_compression) const {
+	if (_region_size <= 0) {
+		LOG(ERROR, "Region has no maps. Skipping ", p_path);
+		return ERR_UNCONFIGURED;
+	}
+	RawHeader header = _get_raw_layout(p_16_bit, p_compression);
+	LocalVector<uint32_t> indices;
+	LocalVector<PackedByteArray> chunk_data;
+	for (int p = 0; p <= TYPE_MAX; p++) {
+		const RawPlane &plane = header.planes[p];
+		PackedByteArray map_data = (p < TYPE_MAX && plane.chunk_count > 0) ? get_map(MapType(p))->get_data() : PackedByteArray();
+		for (uint32_t i = 0; i < plane.chunk_count; i++) {
+			chunk_data.push_back(_get_raw_chunk(header, p, i, map_data, header.chunks[plane.first_chunk + i]));
+			indices.push_back(plane.first_chunk + i);
+		}
+	}
+
+	Ref<FileAccess> file = FileAccess::open(p_path, FileAccess::WRITE);
+	if (file.is_null()) {
+		return FileAccess::get_open_error();
+	}
+	// Reserve the prefix, which is written once the chunks and header are placed
+	PackedByteArray reserved;
+	reserved.resize(RAW_PAGE_SIZE);
+	reserved.fill(0);
+	file->store_buffer(reserved);
+	Error err = _write_raw_chunks(file, header, indices, chunk_data, RAW_PAGE_SIZE);
+	if (err == OK) {
+		err = _write_raw_index(file, header);
+	}
+	file->close();
+	return err;
+}
+
+/**
+ * Updates a file written by save_raw() with the chunks changed since it was written, see
+ * mark_dirty(). The changed chunks and instances are appended to the file, followed by a new
+ * header pointing to them. Only then is the prefix switched to the new header, so a save cut short
+ * leaves the file as it was. The chunks and headers replaced are left in place until the file is
+ * rewritten, which happens once they take up half of it.
+ * Returns ERR_UNAVAILABLE if the file must be rewritten with save_raw(), because the whole
+ * region changed, or the file doesn't match the layout, compression, or format of the region.
+ **/
+Error Terrain3DRegion::update_raw(const String &p_path, const bool p_16_bit, const int p_compression) const {
+	if (_dirty_all || _region_size <= 0 || !FileAccess::file_exists(p_path)) {
+		return ERR_UNAVAILABLE;
+	}
+	RawHeader layout = _get_raw_layout(p_16_bit, p_compression);
+	Ref<FileAccess> file = FileAccess::open(p_path, FileAccess::READ_WRITE);
+	RawHeader header;
+	if (file.is_null() || _read_raw_header(file, header) != OK || header.region_size != layout.region_size ||
+			header.chunk_size != layout.chunk_size || header.compression != layout.compression ||
+			header.chunks.size() != layout.chunks.size()) {
+		return ERR_UNAVAILABLE;
+	}
+	for (int p = 0; p <= TYPE_MAX; p++) {
+		const RawPlane &a = header.planes[p];
+		const RawPlane &b = layout.planes[p];
+		if (a.first_chunk != b.first_chunk || a.chunk_count != b.chunk_count ||
+				(a.chunk_count > 0 && p < TYPE_MAX && (a.format != b.format || a.mipmaps != b.mipmaps))) {
+			return ERR_UNAVAILABLE;
+		}
+	}
+	uint64_t live_size = RAW_PAGE_SIZE + _get_raw_header(header).size();
+	for (const RawChunk &chunk : header.chunks) {
+		live_size += chunk.stored_size;
+	}
+	if (file->get_length() > live_size * 2) {
+		LOG(DEBUG, "Compacting ", p_path);
+		return ERR_UNAVAILABLE;
+	}
+
+	const int chunks_per_side = _region_size / header.chunk_size;
+	const uint32_t map_chunks = chunks_per_side * chunks_per_side;
+	LocalVector<uint32_t> indices;
+	LocalVector<PackedByteArray> chunk_data;
+	for (int p = 0; p < TYPE_MAX; p++) {
+		const RawPlane &plane = header.planes[p];
+		if (plane.chunk_count == 0) {
+			continue;
+		}
+		PackedByteArray map_data;
+		for (uint32_t i = 0; i < MIN(map_chunks, _dirty_chunks.size()); i++) {
+			if (!(_dirty_chunks[i] & (1 << p))) {
+				continue;
+			}
+			if (map_data.is_empty()) {
+				map_data = get_map(MapType(p))->get_data();
+			}
+			chunk_data.push_back(_get_raw_chunk(header, p, i, map_data, header.chunks[plane.first_chunk + i]));
+			indices.push_back(plane.first_chunk + i);
+		}
+		// Mipmaps cover the whole map
+		if (!map_data.is_empty() && plane.mipmaps) {
+			chunk_data.push_back(_get_raw_chunk(header, p, map_chunks, map_data, header.chunks[plane.first_chunk + map_chunks]));
+			indices.push_back(plane.first_chunk + map_chunks);
+		}
+	}
+	// Instance changes aren't tracked, so they are always written
+	const RawPlane &instances = header.planes[TYPE_MAX];
+	chunk_data.push_back(_get_raw_chunk(header, TYPE_MAX, 0, PackedByteArray(), header.chunks[instances.first_chunk]));
+	indices.push_back(instances.first_chunk);
+	header.version = layout.version;
+	header.location = layout.location;
+	header.height_range = layout.height_range;
+
+	// The new header is only switched to once the chunks are on disk
+	Error err = _write_raw_chunks(file, header, indices, chunk_data, file->get_length());
+	if (err == OK) {
+		err = _write_raw_index(file, header);
+	}
+	file->close();
+	LOG(DEBUG, "Updated ", indices.size(), " of ", header.chunks.size(), " chunks in ", p_path);
+	return err;
+}
+
+// Loads a region written by save_raw(). Only maps in p_map_mask are read, the rest are left blank
+// and can be loaded later with load_maps(). Safe to call on any thread.
+Ref<Terrain3DRegion> Terrain3DRegion::load_raw(const String &p_path, const int p_map_mask) {
+	Ref<FileAccess> file = FileAccess::open(p_path, FileAccess::READ);
+	if (file.is_null()) {
+		LOG(ERROR, "Cannot open region file: ", p_path, ". Error code: ", FileAccess::get_open_error());
+		return Ref<Terrain3DRegion>();
+	}
+	RawHeader header;
+	if (_read_raw_header(file, header) != OK) {
+		LOG(ERROR, "Cannot read region file: ", p_path);
+		return Ref<Terrain3DRegion>();
+	}
+
+	Ref<Terrain3DRegion> region;
+	region.instantiate();
+	region->_version = header.version;
+	region->_region_size = header.region_size;
+	region->_location = header.location;
+	Ref<Image> *maps[TYPE_MAX] = { &region->_height_map, &region->_control_map, &region->_color_map };
+	int chunks_per_side = header.region_size / header.chunk_size;
+	for (int i = 0; i < TYPE_MAX; i++) {
+		MapType type = MapType(i);
+		if (header.planes[i].chunk_count == 0) {
+			continue;
+		}
+		if (!(p_map_mask & (1 << i))) {
+			region->_missing_maps |= 1 << i;
+			continue;
+		}
+		Ref<Image> map = _read_raw_map(file, header, type, Rect2i(0, 0, chunks_per_side, chunks_per_side));
+		if (map.is_null()) {
+			LOG(ERROR, "Cannot read ", TYPESTR[type], " from region file: ", p_path);
+			continue;
+		}
+		bool is_format = map->get_format() == FORMAT[type] || (type == TYPE_HEIGHT && is_half_height(map));
+		if (is_format && (type != TYPE_COLOR || map->has_mipmaps())) {
+			// Used as is, no conversion or height range scan
+			*maps[type] = map;
+		} else {
+			region->set_map(type, map);
+		}
+	}
+	PackedByteArray instances;
+	if (_read_raw_chunk(file, header, header.planes[TYPE_MAX].first_chunk, instances)) {
+		region->set_instances(instances);
+	}
+	// Fill any missing maps with blanks
+	region->sanitize_maps();
+	region->_height_range = header.height_range;
+	region->_modified = false;
+	region->clear_dirty();
+	return region;
+}
+
+// Reads one map from a raw region file, decoding only the chunks that overlap p_rect, in pixels.
+// An empty rect returns the whole map, with mipmaps if saved. Safe to call on any thread.
+Ref<Image> Terrain3DRegion::load_raw_map(const String &p_path, const MapType p_map_type, const Rect2i &p_rect) {
+	if (p_map_type < 0 || p_map_type >= TYPE_MAX) {
+		LOG(ERROR, "Specified map type out of range");
+		return Ref<Image>();
+	}
+	Ref<FileAccess> file = FileAccess::open(p_path, FileAccess::READ);
+	RawHeader header;
+	if (file.is_null() || _read_raw_header(file, header) != OK) {
+		LOG(ERROR, "Cannot read region file: ", p_path);
+		return Ref<Image>();
+	}
+	int chunks_per_side = header.region_size / header.chunk_size;
+	Rect2i region_rect = Rect2i(0, 0, header.region_size, header.region_size);
+	Rect2i rect = p_rect.has_area() ? p_rect.intersection(region_rect) : region_rect;
+	if (!rect.has_area()) {
+		LOG(ERROR, "Rect ", p_rect, " is outside of the region");
+		return Ref<Image>();
+	}
+	// Blank maps aren't stored
+	if (header.planes[p_map_type].chunk_count == 0) {
+		bool mipmaps = p_map_type == TYPE_COLOR && rect == region_rect;
+		return Util::get_filled_image(rect.size, COLOR[p_map_type], mipmaps, FORMAT[p_map_type]);
+	}
+	Vector2i first = rect.position / header.chunk_size;
+	Vector2i last = (rect.get_end() - Vector2i(1, 1)) / header.chunk_size;
+	Rect2i chunks = (rect == region_rect) ? Rect2i(0, 0, chunks_per_side, chunks_per_side) : Rect2i(first, last - first + Vector2i(1, 1));
+	Ref<Image> map = _read_raw_map(file, header, p_map_type, chunks);
+	if (map.is_null()) {
+		LOG(ERROR, "Cannot read ", TYPESTR[p_map_type], " from region file: ", p_path);
+		return Ref<Image>();
+	}
+	if (rect != region_rect) {
+		map = map->get_region(rect);
+	}
+	if (map->get_format() != FORMAT[p_map_type]) {
+		map->convert(FORMAT[p_map_type]);
+	}
+	return map;
+}
+
+// Returns the header of a raw region file, and the height range of each height map chunk, in rows
+Dictionary Terrain3DRegion::get_raw_info(const String &p_path) {
+	Dictionary info;
+	Ref<FileAccess> file = FileAccess::open(p_path, FileAccess::READ);
+	RawHeader header;
+	if (file.is_null() || _read_raw_header(file, header) != OK) {
+		LOG(ERROR, "Cannot read region file: ", p_path);
+		return info;
+	}
+	info["version"] = header.version;
+	info["region_size"] = header.region_size;
+	info["location"] = header.location;
+	info["height_range"] = header.height_range;
+	info["chunk_size"] = header.chunk_size;
+	info["compression"] = header.compression;
+	PackedVector2Array ranges;
+	const RawPlane &plane = header.planes[TYPE_HEIGHT];
+	int chunks_per_side = header.region_size / header.chunk_size;
+	for (int i = 0; i < MIN(int(plane.chunk_count), chunks_per_side * chunks_per_side); i++) {
+		ranges.push_back(header.chunks[plane.first_chunk + i].height_range);
+	}
+	info["chunk_height_ranges"] = ranges;
+	return info;
+}
+
+// Returns a copy of this region that can be saved on another thread while this one is edited.
+// Images share their data until either is written. MultiMeshes can only be read on the main
+// thread, so the instances are encoded here.
+Ref<Terrain3DRegion> Terrain3DRegion::get_save_snapshot() const {
+	Ref<Terrain3DRegion> region;
+	region.instantiate();
+	region->_version = Terrain3DData::CURRENT_VERSION;
+	region->_region_size = _region_size;
+	region->_height_range = _height_range;
+	region->_location = _location;
+	// Blank maps are left null, so they are saved as a marker. See is_blank()
+	region->_height_map = (_height_map.is_valid() && !is_blank(TYPE_HEIGHT)) ? _height_map->duplicate() : Ref<Image>();
+	region->_control_map = (_control_map.is_valid() && !is_blank(TYPE_CONTROL)) ? _control_map->duplicate() : Ref<Image>();
+	region->_color_map = (_color_map.is_valid() && !is_blank(TYPE_COLOR)) ? _color_map->duplicate() : Ref<Image>();
+	region->_snapshot_instances = get_instances();
+	region->_dirty_all = _dirty_all;
+	region->_dirty_chunks = _dirty_chunks;
+	return region;
+}
+
+/**
+ * Instances are saved in a compact format instead of the MultiMesh resources, which store 64 bytes per
+ * instance plus any spare capacity. The MultiMeshes are rebuilt from it on load. Layout:
+ *   uint32 INSTANCE_FORMAT, uint32 mesh count
+ *   Per mesh: int32 mesh_id, uint32 cell count
+ *   Per cell: int16 cell x, int16 cell y, uint32 instance count, uint32 compact
+ *     Compact: float3 origin min, float3 origin size, then per instance 16 bytes:
+ *       uint16 x, y, z origin within min & size, uint32 quaternion, half uniform scale, RGBA8 color
+ *     Otherwise: the 16 floats per instance of the MultiMesh buffer
+ * Cells fall back to full precision if any instance has non-uniform scale, shear, mirroring,
+ * or colors outside of 0-1.
+ **/
+PackedByteArray Terrain3DRegion::get_instances() const {
+	if (!_snapshot_instances.is_empty()) {
+		return _snapshot_instances;
+	}
+	LocalVector<uint8_t> out;
+	write_bytes(out, INSTANCE_FORMAT);
+	write_bytes(out, uint32_t(_multimeshes.size()));
+	uint32_t total = 0;
+	Array mesh_ids = _multimeshes.keys();
+	for (int m = 0; m < mesh_ids.size(); m++) {
+		write_bytes(out, int32_t(int(mesh_ids[m])));
+		uint32_t cell_count_pos = out.size();
+		write_bytes(out, uint32_t(0));
+		uint32_t cell_count = 0;
+		Dictionary cell_dict = _multimeshes[mesh_ids[m]];
+		Array cells = cell_dict.keys();
+		for (int c = 0; c < cells.size(); c++) {
+			Ref<MultiMesh> mm = cell_dict[cells[c]];
+			if (mm.is_null()) {
+				continue;
+			}
+			int visible = mm->get_visible_instance_count();
+			int count = (visible < 0) ? mm->get_instance_count() : MIN(visible, mm->get_instance_count());
+			if (count <= 0 || mm->get_transform_format() != MultiMesh::TRANSFORM_3D || !mm->is_using_colors()) {
+				continue;
+			}
+			PackedRealArray buffer = mm->get_buffer();
+			const real_t *src = buffer.ptr();
+			const int stride = 16;
+
+			// Find the origin bounds, and whether every instance can be quantized
+			bool compact = true;
+			AABB bounds = AABB(Vector3(src[3], src[7], src[11]), V3_ZERO);
+			for (int i = 0; i < count; i++) {
+				const real_t *b = src + i * stride;
+				bounds.expand_to(Vector3(b[3], b[7], b[11]));
+				Vector3 x = Vector3(b[0], b[4], b[8]);
+				Vector3 y = Vector3(b[1], b[5], b[9]);
+				Vector3 z = Vector3(b[2], b[6], b[10]);
+				real_t scale = x.length();
+				real_t tolerance = scale * .001f;
+				if (scale < CMP_EPSILON || scale > 65000.f || abs(y.length() - scale) > tolerance ||
+						abs(z.length() - scale) > tolerance || abs(x.dot(y)) > tolerance * scale ||
+						abs(y.dot(z)) > tolerance * scale || abs(z.dot(x)) > tolerance * scale ||
+						x.cross(y).dot(z) < 0.f) {
+					compact = false;
+					break;
+				}
+				for (int k = 12; k < 16; k++) {
+					if (!(b[k] >= 0.f && b[k] <= 1.f)) {
+						compact = false;
+						break;
+					}
+				}
+				if (!compact) {
+					break;
+				}
+			}
+
+			Vector2i cell = cells[c];
+			write_bytes(out, int16_t(cell.x));
+			write_bytes(out, int16_t(cell.y));
+			write_bytes(out, uint32_t(count));
+			write_bytes(out, uint32_t(compact));
+			if (compact) {
+				for (int a = 0; a < 3; a++) {
+					write_bytes(out, float(bounds.position[a]));
+				}
+				for (int a = 0; a < 3; a++) {
+					write_bytes(out, float(bounds.size[a]));
+				}
+				for (int i = 0; i < count; i++) {
+					const real_t *b = src + i * stride;
+					Vector3 origin = Vector3(b[3], b[7], b[11]);
+					for (int a = 0; a < 3; a++) {
+						real_t t = (bounds.size[a] > 0.f) ? (origin[a] - bounds.position[a]) / bounds.size[a] : 0.f;
+						write_bytes(out, uint16_t(Math::round(CLAMP(t, 0.f, 1.f) * 65535.f)));
+					}
+					Vector3 x = Vector3(b[0], b[4], b[8]);
+					real_t scale = x.length();
+					Basis rotation = Basis(x, Vector3(b[1], b[5], b[9]), Vector3(b[2], b[6], b[10])) * (1.f / scale);
+					rotation.orthonormalize();
+					write_bytes(out, encode_quaternion(rotation.get_quaternion()));
+					write_bytes(out, uint16_t(Math::make_half_float(scale)));
+					for (int k = 12; k < 16; k++) {
+						write_bytes(out, uint8_t(Math::round(b[k] * 255.f)));
+					}
+				}
+			} else {
+				for (int i = 0; i < count * stride; i++) {
+					write_bytes(out, float(src[i]));
+				}
+			}
+			cell_count++;
+			total += count;
+		}
+		memcpy(out.ptr() + cell_count_pos, &cell_count, sizeof(uint32_t));
+	}
+
+	PackedByteArray data;
+	data.resize(out.size());
+	memcpy(data.ptrw(), out.ptr(), out.size());
+	LOG(DEBUG, "Encoded ", total, " instances in ", out.size(), " bytes for region ", _location);
+	return data;
+}
+
+// Rebuilds the MultiMeshes from the compact format written by get_instances()
+void Terrain3DRegion::set_instances(const PackedByteArray &p_data) {
+	_multimeshes.clear();
+	if (p_data.is_empty()) {
+		return;
+	}
+	const uint8_t *src = p_data.ptr();
+	int64_t size = p_data.size();
+	int64_t pos = 0;
+	uint32_t format = 0;
+	uint32_t mesh_count = 0;
+	if (!read_bytes(src, size, pos, format) || format != INSTANCE_FORMAT || !read_bytes(src, size, pos, mesh_count)) {
+		LOG(ERROR, "Unknown instance data format ", format, " in region ", get_path());
+		return;
+	}
+	for (uint32_t m = 0; m < mesh_count; m++) {
+		int32_t mesh_id = 0;
+		uint32_t cell_count = 0;
+		if (!read_bytes(src, size, pos, mesh_id) || !read_bytes(src, size, pos, cell_count)) {
+			break;
+		}
+		Dictionary cell_dict;
+		for (uint32_t c = 0; c < cell_count; c++) {
+			int16_t cell_x = 0;
+			int16_t cell_y = 0;
+			uint32_t count = 0;
+			uint32_t compact = 0;
+			if (!read_bytes(src, size, pos, cell_x) || !read_bytes(src, size, pos, cell_y) ||
+					!read_bytes(src, size, pos, count) || !read_bytes(src, size, pos, compact)) {
+				LOG(ERROR, "Instance data truncated in region ", get_path());
+				return;
+			}
+			int64_t needed = compact ? int64_t(6 * sizeof(float)) + int64_t(count) * 16 : int64_t(count) * 16 * sizeof(float);
+			if (pos + needed > size) {
+				LOG(ERROR, "Instance data truncated in region ", get_path());
+				return;
+			}
+			PackedRealArray buffer;
+			buffer.resize(int64_t(count) * 16);
+			real_t *dst = buffer.ptrw();
+			if (compact) {
+				float bounds[6];
+				for (int a = 0; a < 6; a++) {
+					read_bytes(src, size, pos, bounds[a]);
+				}
+				Vector3 min = Vector3(bounds[0], bounds[1], bounds[2]);
+				Vector3 extent = Vector3(bounds[3], bounds[4], bounds[5]);
+				for (uint32_t i = 0; i < count; i++) {
+					uint16_t q[3];
+					uint32_t rotation = 0;
+					uint16_t half_scale = 0;
+					uint8_t color[4];
+					for (int a = 0; a < 3; a++) {
+						read_bytes(src, size, pos, q[a]);
+					}
+					read_bytes(src, size, pos, rotation);
+					read_bytes(src, size, pos, half_scale);
+					for (int k = 0; k < 4; k++) {
+						read_bytes(src, size, pos, color[k]);
+					}
+					Vector3 origin = min + Vector3(q[0], q[1], q[2]) / 65535.f * extent;
+					real_t scale = Math::half_to_float(half_scale);
+					Basis basis = Basis(decode_quaternion(rotation)) * scale;
+					real_t *b = dst + i * 16;
+					for (int r = 0; r < 3; r++) {
+						b[r * 4 + 0] = basis.rows[r].x;
+						b[r * 4 + 1] = basis.rows[r].y;
+						b[r * 4 + 2] = basis.rows[r].z;
+						b[r * 4 + 3] = origin[r];
+					}
+					for (int k = 0; k < 4; k++) {
+						b[12 + k] = real_t(color[k]) / 255.f;
+					}
+				}
+			} else {
+				for (uint32_t i = 0; i < count * 16; i++) {
+					float value = 0.f;
+					read_bytes(src, size, pos, value);
+					dst[i] = value;
+				}
+			}
+			Ref<MultiMesh> mm;
+			mm.instantiate();
+			mm->set_transform_format(MultiMesh::TRANSFORM_3D);
+			mm->set_use_colors(true);
+			mm->set_instance_count(count);
+			mm->set_buffer(buffer);
+			cell_dict[Vector2i(cell_x, cell_y)] = mm;
+		}
+		if (!cell_dict.is_empty()) {
+			_multimeshes[int(mesh_id)] = cell_dict;
+		}
+	}
+}
+
+// Marks the chunks of a map overlapping p_rect, in pixels, to be saved. TYPE_MAX marks every map,
+// and an empty rect the whole map. Also marks the region modified.
+void Terrain3DRegion::mark_dirty(const MapType p_map_type, const Rect2i &p_rect) {
+	_modified = true;
+	if (_dirty_all) {
+		return;
+	}
+	if (p_map_type < 0 || p_map_type >= TYPE_MAX || _region_size <= 0) {
+		_dirty_all = true;
+		return;
+	}
+	const int chunk_size = MIN(RAW_CHUNK_SIZE, _region_size);
+	const int chunks_per_side = _region_size / chunk_size;
+	if (_dirty_chunks.size() != uint32_t(chunks_per_side * chunks_per_side)) {
+		_dirty_chunks.resize(chunks_per_side * chunks_per_side);
+		memset(_dirty_chunks.ptr(), 0, _dirty_chunks.size());
+	}
+	Rect2i region_rect = Rect2i(0, 0, _region_size, _region_size);
+	Rect2i rect = (p_rect == Rect2i()) ? region_rect : p_rect.intersection(region_rect);
+	if (!rect.has_area()) {
+		return;
+	}
+	Vector2i first = rect.position / chunk_size;
+	Vector2i last = (rect.get_end() - Vector2i(1, 1)) / chunk_size;
+	for (int y = first.y; y <= last.y; y++) {
+		for (int x = first.x; x <= last.x; x++) {
+			_dirty_chunks[y * chunks_per_side + x] |= 1 << p_map_type;
+		}
+	}
+}
+
+// Called once the region has been written, or a copy of it taken to be written
+void Terrain3DRegion::clear_dirty() {
+	_dirty_all = false;
+	_dirty_chunks.clear();
+}
+
 void Terrain3DRegion::set_location(const Vector2i &p_location) {
 	// In the future anywhere they want to put the location might be fine, but because of region_map
 	// We have a limitation of 16x16 and eventually 45x45.
@@ -262,6 +1231,7 @@ void Terrain3DRegion::set_data(const Dictionary &p_data) {
 	SET_IF_HAS(_control_map, "control_map");
 	SET_IF_HAS(_color_map, "color_map");
 	SET_IF_HAS(_multimeshes, "multimeshes");
+	_dirty_all = true;
 }
 
 Dictionary Terrain3DRegion::get_data() const {
@@ -299,13 +1269,21 @@ Ref<Terrain3DRegion> Terrain3DRegion::duplicate(const bool p_deep) {
 		dict["height_map"] = _height_map->duplicate();
 		dict["control_map"] = _control_map->duplicate();
 		dict["color_map"] = _color_map->duplicate();
+		// Multimeshes are edited in place, so backups need their own copy
 		Dictionary mms;
 		Array keys = _multimeshes.keys();
 		for (int i = 0; i < keys.size(); i++) {
 			int mesh_id = keys[i];
-			Ref<MultiMesh> mm = _multimeshes[mesh_id];
-			mm->duplicate();
-			mms[mesh_id] = mm;
+			Dictionary cell_dict = _multimeshes[mesh_id];
+			Dictionary cells;
+			Array cell_keys = cell_dict.keys();
+			for (int c = 0; c < cell_keys.size(); c++) {
+				Ref<MultiMesh> mm = cell_dict[cell_keys[c]];
+				if (mm.is_valid()) {
+					cells[cell_keys[c]] = mm->duplicate();
+				}
+			}
+			mms[mesh_id] = cells;
 		}
 		dict["multimeshes"] = mms;
 		region->set_data(dict);
@@ -317,6 +1295,15 @@ Ref<Terrain3DRegion> Terrain3DRegion::duplicate(const bool p_deep) {
 // Protected Functions
 /////////////////////
 
+// Scripts can't report which pixels they changed, so setting a region modified from a script saves all of it
+void Terrain3DRegion::_set_modified_bind(const bool p_modified) {
+	if (p_modified) {
+		mark_dirty();
+	} else {
+		_modified = false;
+	}
+}
+
 void Terrain3DRegion::_bind_methods() {
 	BIND_ENUM_CONSTANT(TYPE_HEIGHT);
 	BIND_ENUM_CONSTANT(TYPE_CONTROL);
@@ -341,6 +1328,10 @@ void Terrain3DRegion::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("sanitize_maps"), &Terrain3DRegion::sanitize_maps);
 	ClassDB::bind_method(D_METHOD("sanitize_map", "map_type", "map"), &Terrain3DRegion::sanitize_map);
 	ClassDB::bind_method(D_METHOD("validate_map_size", "map"), &Terrain3DRegion::validate_map_size);
+	ClassDB::bind_method(D_METHOD("is_blank", "map_type"), &Terrain3DRegion::is_blank);
+	ClassDB::bind_method(D_METHOD("unload_maps", "map_mask"), &Terrain3DRegion::unload_maps);
+	ClassDB::bind_method(D_METHOD("load_maps", "map_mask"), &Terrain3DRegion::load_maps, DEFVAL(ALL_MAPS));
+	ClassDB::bind_method(D_METHOD("get_missing_maps"), &Terrain3DRegion::get_missing_maps);
 
 	ClassDB::bind_method(D_METHOD("set_height_range", "range"), &Terrain3DRegion::set_height_range);
 	ClassDB::bind_method(D_METHOD("get_height_range"), &Terrain3DRegion::get_height_range);
@@ -350,15 +1341,23 @@ void Terrain3DRegion::_bind_methods() {
 
 	ClassDB::bind_method(D_METHOD("set_multimeshes", "multimeshes"), &Terrain3DRegion::set_multimeshes);
 	ClassDB::bind_method(D_METHOD("get_multimeshes"), &Terrain3DRegion::get_multimeshes);
+	ClassDB::bind_method(D_METHOD("set_instances", "data"), &Terrain3DRegion::set_instances);
+	ClassDB::bind_method(D_METHOD("get_instances"), &Terrain3DRegion::get_instances);
 
-	ClassDB::bind_method(D_METHOD("save", "path", "16-bit"), &Terrain3DRegion::save, DEFVAL(""), DEFVAL(false));
+	ClassDB::bind_method(D_METHOD("save", "path", "16-bit", "compression"), &Terrain3DRegion::save, DEFVAL(""), DEFVAL(false), DEFVAL(RAW_UNCOMPRESSED));
+	ClassDB::bind_method(D_METHOD("save_raw", "path", "16-bit", "compression"), &Terrain3DRegion::save_raw, DEFVAL(false), DEFVAL(RAW_UNCOMPRESSED));
+	ClassDB::bind_method(D_METHOD("update_raw", "path", "16-bit", "compression"), &Terrain3DRegion::update_raw, DEFVAL(false), DEFVAL(RAW_UNCOMPRESSED));
+	ClassDB::bind_static_method("Terrain3DRegion", D_METHOD("load_raw", "path", "map_mask"), &Terrain3DRegion::load_raw, DEFVAL(ALL_MAPS));
+	ClassDB::bind_static_method("Terrain3DRegion", D_METHOD("load_raw_map", "path", "map_type", "rect"), &Terrain3DRegion::load_raw_map, DEFVAL(Rect2i()));
+	ClassDB::bind_static_method("Terrain3DRegion", D_METHOD("get_raw_info", "path"), &Terrain3DRegion::get_raw_info);
 
 	ClassDB::bind_method(D_METHOD("set_deleted", "deleted"), &Terrain3DRegion::set_deleted);
 	ClassDB::bind_method(D_METHOD("is_deleted"), &Terrain3DRegion::is_deleted);
 	ClassDB::bind_method(D_METHOD("set_edited", "edited"), &Terrain3DRegion::set_edited);
 	ClassDB::bind_method(D_METHOD("is_edited"), &Terrain3DRegion::is_edited);
-	ClassDB::bind_method(D_METHOD("set_modified", "modified"), &Terrain3DRegion::set_modified);
+	ClassDB::bind_method(D_METHOD("set_modified", "modified"), &Terrain3DRegion::_set_modified_bind);
 	ClassDB::bind_method(D_METHOD("is_modified"), &Terrain3DRegion::is_modified);
+	ClassDB::bind_method(D_METHOD("mark_dirty", "map_type", "rect"), &Terrain3DRegion::mark_dirty, DEFVAL(TYPE_MAX), DEFVAL(Rect2i()));
 	ClassDB::bind_method(D_METHOD("set_location", "location"), &Terrain3DRegion::set_location);
 	ClassDB::bind_method(D_METHOD("get_location"), &Terrain3DRegion::get_location);
 
@@ -373,7 +1372,9 @@ void Terrain3DRegion::_bind_methods() {
 	ADD_PROPERTY(PropertyInfo(Variant::OBJECT, "height_map", PROPERTY_HINT_RESOURCE_TYPE, "Image", ro_flags), "set_height_map", "get_height_map");
 	ADD_PROPERTY(PropertyInfo(Variant::OBJECT, "control_map", PROPERTY_HINT_RESOURCE_TYPE, "Image", ro_flags), "set_control_map", "get_control_map");
 	ADD_PROPERTY(PropertyInfo(Variant::OBJECT, "color_map", PROPERTY_HINT_RESOURCE_TYPE, "Image", ro_flags), "set_color_map", "get_color_map");
-	ADD_PROPERTY(PropertyInfo(Variant::DICTIONARY, "multimeshes", PROPERTY_HINT_NONE, "", ro_flags), "set_multimeshes", "get_multimeshes");
+	// Multimeshes are saved as compact instances. The property still loads files from earlier versions
+	ADD_PROPERTY(PropertyInfo(Variant::DICTIONARY, "multimeshes", PROPERTY_HINT_NONE, "", PROPERTY_USAGE_EDITOR | PROPERTY_USAGE_READ_ONLY), "set_multimeshes", "get_multimeshes");
+	ADD_PROPERTY(PropertyInfo(Variant::PACKED_BYTE_ARRAY, "instances", PROPERTY_HINT_NONE, "", PROPERTY_USAGE_STORAGE), "set_instances", "get_instances");
 
 	// Double-clicking a region .res file shows what's on disk, the defaults, not in memory. So these are hidden
 	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "edited", PROPERTY_HINT_NONE, "", PROPERTY_USAGE_NONE), "set_edited", "is_edited");
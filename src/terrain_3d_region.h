@@ -3,6 +3,8 @@
 #ifndef TERRAIN3D_REGION_CLASS_H
 #define TERRAIN3D_REGION_CLASS_H
 
+#include <godot_cpp/classes/file_access.hpp>
+
 #include "constants.h"
 #include "terrain_3d_util.h"
 
@@ -27,6 +29,9 @@ public: // Constants
 		Image::Format(TYPE_MAX), // Proper size of array instead of FORMAT_MAX
 	};
 
+	// Bit per MapType, see Terrain3D::resident_maps
+	static inline const int ALL_MAPS = (1 << TYPE_MAX) - 1;
+
 	static inline const char *TYPESTR[] = {
 		"TYPE_HEIGHT",
 		"TYPE_CONTROL",
@@ -34,6 +39,18 @@ public: // Constants
 		"TYPE_MAX",
 	};
 
+	// Format of the compact instance data saved in place of the multimeshes, see get_instances()
+	static inline const uint32_t INSTANCE_FORMAT = 1;
+
+	// Chunked region files, see save_raw()
+	static inline const char *RAW_EXTENSION = "t3dr";
+	static inline const uint32_t RAW_MAGIC = 0x52443354; // "T3DR"
+	static inline const uint32_t RAW_FORMAT = 3;
+	static inline const int64_t RAW_PREFIX_SIZE = 20; // Magic, format, header offset and size
+	static inline const int64_t RAW_PAGE_SIZE = 4096;
+	static inline const int RAW_CHUNK_SIZE = 128; // Pixels on a side of each map chunk
+	static inline const int RAW_UNCOMPRESSED = -1; // Otherwise a FileAccess::CompressionMode
+
 	static inline const Color COLOR[] = {
 		COLOR_BLACK, // TYPE_HEIGHT
 		COLOR_CONTROL, // TYPE_CONTROL
@@ -51,13 +68,53 @@ private:
 	Ref<Image> _control_map;
 	Ref<Image> _color_map;
 	// Instancer
-	Dictionary _multimeshes; // Dictionary[mesh_id:int] -> MultiMesh
+	Dictionary _multimeshes; // Dictionary[mesh_id:int] -> Dictionary[cell:Vector2i] -> MultiMesh
 
 	// Working data not saved to disk
 	bool _deleted = false; // Marked for deletion on save
 	bool _edited = false; // Marked for undo/redo storage
 	bool _modified = false; // Marked for saving
+	int _missing_maps = 0; // Bits of maps not loaded from the region file, see unload_maps()
 	Vector2i _location = V2I_MAX;
+	PackedByteArray _snapshot_instances; // Encoded by get_save_snapshot(), saved instead of _multimeshes
+
+	// Index of a raw region file, see save_raw()
+	struct RawChunk {
+		uint64_t offset = 0;
+		uint32_t stored_size = 0; // Compressed if less than size
+		uint32_t size = 0;
+		Vector2 height_range = V2_ZERO; // Height map chunks only
+	};
+	struct RawPlane {
+		Image::Format format = Image::FORMAT_MAX;
+		bool mipmaps = false;
+		uint32_t first_chunk = 0;
+		uint32_t chunk_count = 0;
+	};
+	struct RawHeader {
+		real_t version = 0.f;
+		int region_size = 0;
+		Vector2i location = V2I_ZERO;
+		Vector2 height_range = V2_ZERO;
+		int chunk_size = 0;
+		int compression = RAW_UNCOMPRESSED;
+		RawPlane planes[TYPE_MAX + 1]; // Maps, then instances
+		LocalVector<RawChunk> chunks;
+	};
+
+	// Chunks changed since the region was last saved or loaded, see mark_dirty()
+	bool _dirty_all = true;
+	LocalVector<uint8_t> _dirty_chunks; // Bit per map type, per chunk of RAW_CHUNK_SIZE
+
+	RawHeader _get_raw_layout(const bool p_16_bit, const int p_compression) const;
+	PackedByteArray _get_raw_chunk(const RawHeader &p_header, const int p_plane, const uint32_t p_index, const PackedByteArray &p_map_data, RawChunk &r_chunk) const;
+	static PackedByteArray _get_raw_header(const RawHeader &p_header);
+	static Error _write_raw_chunks(const Ref<FileAccess> &p_file, RawHeader &r_header, const LocalVector<uint32_t> &p_indices, const LocalVector<PackedByteArray> &p_data, uint64_t p_offset);
+	static Error _write_raw_index(const Ref<FileAccess> &p_file, const RawHeader &p_header);
+	static PackedByteArray _compress_raw_chunk(const PackedByteArray &p_data, const int p_compression, RawChunk &r_chunk);
+	static Error _read_raw_header(const Ref<FileAccess> &p_file, RawHeader &r_header);
+	static bool _read_raw_chunk(const Ref<FileAccess> &p_file, const RawHeader &p_header, const uint32_t p_index, PackedByteArray &r_data);
+	static Ref<Image> _read_raw_map(const Ref<FileAccess> &p_file, const RawHeader &p_header, const MapType p_map_type, const Rect2i &p_chunks);
 
 public:
 	Terrain3DRegion() {}
@@ -82,6 +139,10 @@ public:
 	void sanitize_maps();
 	Ref<Image> sanitize_map(const MapType p_map_type, const Ref<Image> &p_map) const;
 	bool validate_map_size(const Ref<Image> &p_map) const;
+	bool is_blank(const MapType p_map_type) const;
+	void unload_maps(const int p_map_mask);
+	Error load_maps(const int p_map_mask = ALL_MAPS);
+	int get_missing_maps() const { return _missing_maps; }
 
 	void set_height_range(const Vector2 &p_range);
 	Vector2 get_height_range() const { return _height_range; }
@@ -92,9 +153,17 @@ public:
 	// Instancer
 	void set_multimeshes(const Dictionary &p_multimeshes) { _multimeshes = p_multimeshes; }
 	Dictionary get_multimeshes() const { return _multimeshes; }
+	void set_instances(const PackedByteArray &p_data);
+	PackedByteArray get_instances() const;
 
 	// File I/O
-	Error save(const String &p_path = "", const bool p_16_bit = false);
+	Error save(const String &p_path = "", const bool p_16_bit = false, const int p_compression = RAW_UNCOMPRESSED);
+	Error save_raw(const String &p_path, const bool p_16_bit = false, const int p_compression = RAW_UNCOMPRESSED) const;
+	Error update_raw(const String &p_path, const bool p_16_bit = false, const int p_compression = RAW_UNCOMPRESSED) const;
+	static Ref<Terrain3DRegion> load_raw(const String &p_path, const int p_map_mask = ALL_MAPS);
+	static Ref<Image> load_raw_map(const String &p_path, const MapType p_map_type, const Rect2i &p_rect = Rect2i());
+	static Dictionary get_raw_info(const String &p_path);
+	Ref<Terrain3DRegion> get_save_snapshot() const;
 
 	// Working Data
 	void set_deleted(const bool p_deleted) { _deleted = p_deleted; }
@@ -103,6 +172,8 @@ public:
 	bool is_edited() const { return _edited; }
 	void set_modified(const bool p_modified) { _modified = p_modified; }
 	bool is_modified() const { return _modified; }
+	void mark_dirty(const MapType p_map_type = TYPE_MAX, const Rect2i &p_rect = Rect2i());
+	void clear_dirty();
 	void set_location(const Vector2i &p_location);
 	Vector2i get_location() const { return _location; }
 
@@ -112,6 +183,7 @@ public:
 	Ref<Terrain3DRegion> duplicate(const bool p_deep = false);
 
 protected:
+	void _set_modified_bind(const bool p_modified);
 	static void _bind_methods();
 };
 
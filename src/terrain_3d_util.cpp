@@ -2,6 +2,7 @@
 
 #include <godot_cpp/classes/engine.hpp>
 #include <godot_cpp/classes/file_access.hpp>
+#include <godot_cpp/classes/worker_thread_pool.hpp>
 
 #include "logger.h"
 #include "terrain_3d_util.h"
@@ -77,7 +78,7 @@ void Terrain3DUtil::dump_maps(const TypedArray<Image> &p_maps, const String &p_n
 
 // Expects a filename in a String like: "terrain3d-01_02.res" which returns (-1, 2)
 Vector2i Terrain3DUtil::filename_to_location(const String &p_filename) {
-	String working_string = p_filename.trim_suffix(".res");
+	String working_string = p_filename.get_basename();
 	String y_str = working_string.right(3).replace("_", "");
 	working_string = working_string.erase(working_string.length() - 3, 3);
 	String x_str = working_string.right(3).replace("_", "");
@@ -300,14 +301,18 @@ Ref<Image> Terrain3DUtil::load_image(const String &p_file_name, const int p_cach
 			LOG(DEBUG, "Total file size is: ", fsize, " calculated width: ", fwidth, " dimensions: ", r16_size);
 			file->seek(0);
 		}
-		img = Image::create(r16_size.x, r16_size.y, false, FORMAT[TYPE_HEIGHT]);
-		for (int y = 0; y < r16_size.y; y++) {
-			for (int x = 0; x < r16_size.x; x++) {
-				real_t h = real_t(file->get_16()) / 65535.0f;
-				h = h * (p_r16_height_range.y - p_r16_height_range.x) + p_r16_height_range.x;
-				img->set_pixel(x, y, Color(h, 0.f, 0.f));
-			}
+		// Read the whole file at once and convert it straight into the image data
+		int64_t count = int64_t(r16_size.x) * r16_size.y;
+		PackedByteArray src = file->get_buffer(count * 2);
+		if (src.size() < count * 2) {
+			LOG(ERROR, "File ", p_file_name, " is smaller than ", r16_size, " 16-bit pixels");
+			return Ref<Image>();
 		}
+		PackedByteArray data;
+		data.resize(count * sizeof(float));
+		real_t scale = (p_r16_height_range.y - p_r16_height_range.x) / 65535.0f;
+		r16_to_heights(src.ptr(), reinterpret_cast<float *>(data.ptrw()), count, scale, p_r16_height_range.x);
+		img = Image::create_from_data(r16_size.x, r16_size.y, false, FORMAT[TYPE_HEIGHT], data);
 
 		// If an Image extension, use Image loader
 	} else if (imgloader_extensions.has(ext)) {
@@ -412,6 +417,65 @@ Ref<Image> Terrain3DUtil::luminance_to_height(const Ref<Image> &p_src_rgb) {
 	return dst;
 }
 
+/* Regenerates only the mipmap texels covering p_rect on the base level, walking up the chain.
+ * Uses the same box filter as Image::generate_mipmaps() so results are identical.
+ * Supports FORMAT_RGBA8 with power of 2 dimensions. Other images regenerate all mipmaps.
+ */
+void Terrain3DUtil::update_mipmaps(const Ref<Image> &p_image, const Rect2i &p_rect) {
+	if (p_image.is_null() || p_image->is_empty() || !p_image->has_mipmaps()) {
+		return;
+	}
+	Vector2i src_size = p_image->get_size();
+	if (p_image->get_format() != Image::FORMAT_RGBA8 || !is_power_of_2(src_size.x) || !is_power_of_2(src_size.y)) {
+		p_image->generate_mipmaps();
+		return;
+	}
+	Rect2i rect = p_rect.intersection(Rect2i(V2I_ZERO, src_size));
+	if (!rect.has_area()) {
+		return;
+	}
+	uint8_t *data = p_image->ptrw();
+	int mipmap_count = p_image->get_mipmap_count();
+	for (int level = 1; level <= mipmap_count; level++) {
+		Vector2i dst_size = Vector2i(MAX(src_size.x / 2, 1), MAX(src_size.y / 2, 1));
+		// Cover every texel that contains a dirty source texel
+		Vector2i start = rect.position / 2;
+		Vector2i end = (rect.get_end() + Vector2i(1, 1)) / 2;
+		end = Vector2i(MIN(end.x, dst_size.x), MIN(end.y, dst_size.y));
+		const uint8_t *src = data + p_image->get_mipmap_offset(level - 1);
+		uint8_t *dst = data + p_image->get_mipmap_offset(level);
+		for (int y = start.y; y < end.y; y++) {
+			const uint8_t *row0 = src + MIN(y * 2, src_size.y - 1) * src_size.x * 4;
+			const uint8_t *row1 = src + MIN(y * 2 + 1, src_size.y - 1) * src_size.x * 4;
+			for (int x = start.x; x < end.x; x++) {
+				int x0 = MIN(x * 2, src_size.x - 1) * 4;
+				int x1 = MIN(x * 2 + 1, src_size.x - 1) * 4;
+				uint8_t *texel = dst + (y * dst_size.x + x) * 4;
+				for (int c = 0; c < 4; c++) {
+					uint16_t sum = uint16_t(row0[x0 + c]) + row0[x1 + c] + row1[x0 + c] + row1[x1 + c];
+					texel[c] = uint8_t((sum + 2) >> 2);
+				}
+			}
+		}
+		rect = Rect2i(start, end - start);
+		src_size = dst_size;
+	}
+}
+
+// Calls p_callable with each index from 0 to p_count - 1 on the WorkerThreadPool, then waits for
+// all of them to finish. A single index runs on the calling thread.
+void Terrain3DUtil::run_group_task(const Callable &p_callable, const int p_count, const String &p_description) {
+	if (p_count <= 0) {
+		return;
+	} else if (p_count == 1) {
+		p_callable.call(0);
+		return;
+	}
+	WorkerThreadPool *wtp = WorkerThreadPool::get_singleton();
+	int64_t group_id = wtp->add_group_task(p_callable, p_count, -1, true, p_description);
+	wtp->wait_for_group_task_completion(group_id);
+}
+
 ///////////////////////////
 // Protected Functions
 ///////////////////////////
@@ -449,4 +513,5 @@ void Terrain3DUtil::_bind_methods() {
 	ClassDB::bind_static_method("Terrain3DUtil", D_METHOD("load_image", "file_name", "cache_mode", "r16_height_range", "r16_size"), &Terrain3DUtil::load_image, DEFVAL(ResourceLoader::CACHE_MODE_IGNORE), DEFVAL(Vector2(0, 255)), DEFVAL(V2I_ZERO));
 	ClassDB::bind_static_method("Terrain3DUtil", D_METHOD("pack_image", "src_rgb", "src_a", "invert_green", "invert_alpha", "alpha_channel"), &Terrain3DUtil::pack_image, DEFVAL(false));
 	ClassDB::bind_static_method("Terrain3DUtil", D_METHOD("luminance_to_height", "src_rgb"), &Terrain3DUtil::luminance_to_height, DEFVAL(false));
+	ClassDB::bind_static_method("Terrain3DUtil", D_METHOD("update_mipmaps", "image", "rect"), &Terrain3DUtil::update_mipmaps);
 }
@@ -5,6 +5,7 @@
 
 #include <godot_cpp/classes/image.hpp>
 #include <godot_cpp/classes/resource_loader.hpp>
+#include <godot_cpp/templates/local_vector.hpp>
 
 #include "constants.h"
 #include "generated_texture.h"
@@ -47,6 +48,10 @@ public:
 			const bool p_invert_alpha = false,
 			const int p_alpha_channel = 0);
 	static Ref<Image> luminance_to_height(const Ref<Image> &p_src_rgb);
+	static void update_mipmaps(const Ref<Image> &p_image, const Rect2i &p_rect);
+
+	// Threading
+	static void run_group_task(const Callable &p_callable, const int p_count, const String &p_description = "");
 
 
 protected:
@@ -101,6 +106,44 @@ inline real_t bilerp(const real_t p_v00, const real_t p_v01, const real_t p_v10,
 	return bilerp(p_v00, p_v01, p_v10, p_v11, pos00, pos11, pos);
 }
 
+// Integer hash for deterministic random numbers on worker threads, eg for seeded, multithreaded
+// operations that can't share a RandomNumberGenerator
+inline uint32_t hash32(uint32_t p_value) {
+	p_value ^= p_value >> 16;
+	p_value *= 0x7feb352dU;
+	p_value ^= p_value >> 15;
+	p_value *= 0x846ca68bU;
+	p_value ^= p_value >> 16;
+	return p_value;
+}
+
+// Returns a random value from 0 to 1 and advances p_state
+inline real_t rand_float(uint32_t &p_state) {
+	p_state += 0x9e3779b9U;
+	return real_t(hash32(p_state) >> 8) / real_t(1 << 24);
+}
+
+// Returns 2D gradient noise from about -1 to 1 at p_pos, with features one unit apart
+inline real_t gradient_noise(const Vector2 &p_pos, const uint32_t p_seed) {
+	static const real_t grads[8][2] = { { 1.f, 0.f }, { -1.f, 0.f }, { 0.f, 1.f }, { 0.f, -1.f },
+		{ Math_SQRT12, Math_SQRT12 }, { -Math_SQRT12, Math_SQRT12 }, { Math_SQRT12, -Math_SQRT12 }, { -Math_SQRT12, -Math_SQRT12 } };
+	Vector2 cell = p_pos.floor();
+	Vector2 f = p_pos - cell;
+	int32_t x = int32_t(cell.x);
+	int32_t y = int32_t(cell.y);
+	real_t dots[4];
+	for (int i = 0; i < 4; i++) {
+		int32_t dx = i & 1;
+		int32_t dy = i >> 1;
+		uint32_t h = hash32(p_seed ^ hash32(uint32_t(x + dx) ^ hash32(uint32_t(y + dy)))) & 7;
+		dots[i] = grads[h][0] * (f.x - dx) + grads[h][1] * (f.y - dy);
+	}
+	// Quintic fade for continuous derivatives
+	real_t u = f.x * f.x * f.x * (f.x * (f.x * 6.f - 15.f) + 10.f);
+	real_t v = f.y * f.y * f.y * (f.y * (f.y * 6.f - 15.f) + 10.f);
+	return Math::lerp(Math::lerp(dots[0], dots[1], u), Math::lerp(dots[2], dots[3], u), v) * Math_SQRT2;
+}
+
 inline Rect2 aabb2rect(const AABB &p_aabb) {
 	Rect2 rect;
 	rect.position = Vector2(p_aabb.position.x, p_aabb.position.z);
@@ -108,6 +151,135 @@ inline Rect2 aabb2rect(const AABB &p_aabb) {
 	return rect;
 }
 
+///////////////////////////
+// Binary Data
+///////////////////////////
+
+// Unsigned integer the size of a value, so its bytes can be ordered with shifts
+template <size_t S>
+struct ByteBits;
+template <>
+struct ByteBits<1> { typedef uint8_t Type; };
+template <>
+struct ByteBits<2> { typedef uint16_t Type; };
+template <>
+struct ByteBits<4> { typedef uint32_t Type; };
+template <>
+struct ByteBits<8> { typedef uint64_t Type; };
+
+// Appends the bytes of a value to a buffer, for compact binary formats. Always little endian.
+template <typename T>
+inline void write_bytes(LocalVector<uint8_t> &p_buffer, const T &p_value) {
+	typedef typename ByteBits<sizeof(T)>::Type Bits;
+	Bits bits;
+	memcpy(&bits, &p_value, sizeof(T));
+	uint32_t pos = p_buffer.size();
+	p_buffer.resize(pos + sizeof(T));
+	for (uint32_t i = 0; i < sizeof(T); i++) {
+		p_buffer[pos + i] = uint8_t(bits >> (i * 8));
+	}
+}
+
+// Reads a little endian value from a buffer at p_pos and advances it. Returns false if it would
+// read past p_size.
+template <typename T>
+inline bool read_bytes(const uint8_t *p_buffer, const int64_t p_size, int64_t &p_pos, T &r_value) {
+	if (p_pos < 0 || p_pos + int64_t(sizeof(T)) > p_size) {
+		return false;
+	}
+	typedef typename ByteBits<sizeof(T)>::Type Bits;
+	Bits bits = 0;
+	for (uint32_t i = 0; i < sizeof(T); i++) {
+		bits |= Bits(Bits(p_buffer[p_pos + i]) << (i * 8));
+	}
+	memcpy(&r_value, &bits, sizeof(T));
+	p_pos += sizeof(T);
+	return true;
+}
+
+// Packs a unit quaternion into 32 bits: the index of the largest component in 2 bits, and
+// the other three, which lie within +/- 1/sqrt(2), in 10 bits each
+inline uint32_t encode_quaternion(const Quaternion &p_quat) {
+	real_t q[4] = { p_quat.x, p_quat.y, p_quat.z, p_quat.w };
+	uint32_t largest = 0;
+	for (uint32_t i = 1; i < 4; i++) {
+		if (abs(q[i]) > abs(q[largest])) {
+			largest = i;
+		}
+	}
+	// q and -q are the same rotation, so make the dropped component positive
+	real_t sign = (q[largest] < 0.f) ? -1.f : 1.f;
+	uint32_t bits = largest << 30;
+	int shift = 20;
+	for (uint32_t i = 0; i < 4; i++) {
+		if (i != largest) {
+			real_t v = CLAMP(q[i] * sign * Math_SQRT12 + .5f, 0.f, 1.f);
+			bits |= uint32_t(Math::round(v * 1023.f)) << shift;
+			shift -= 10;
+		}
+	}
+	return bits;
+}
+
+inline Quaternion decode_quaternion(const uint32_t p_bits) {
+	uint32_t largest = p_bits >> 30;
+	real_t q[4];
+	real_t sum = 0.f;
+	int shift = 20;
+	for (uint32_t i = 0; i < 4; i++) {
+		if (i != largest) {
+			q[i] = (real_t((p_bits >> shift) & 0x3FF) / 1023.f - .5f) * Math_SQRT2;
+			sum += q[i] * q[i];
+			shift -= 10;
+		}
+	}
+	q[largest] = Math::sqrt(MAX(0.f, 1.f - sum));
+	return Quaternion(q[0], q[1], q[2], q[3]).normalized();
+}
+
+///////////////////////////
+// Heightmap Handling
+///////////////////////////
+
+// Height maps are FORMAT_RF, or FORMAT_RH when kept as half floats, see Terrain3D.runtime_16_bit.
+// These read and write heights by pixel index in the data of either, p_half for FORMAT_RH.
+inline bool is_half_height(const Ref<Image> &p_map) { return p_map->get_format() == Image::FORMAT_RH; }
+
+inline float get_height_value(const uint8_t *p_data, const bool p_half, const int64_t p_index) {
+	if (p_half) {
+		return Math::half_to_float(reinterpret_cast<const uint16_t *>(p_data)[p_index]);
+	}
+	return reinterpret_cast<const float *>(p_data)[p_index];
+}
+
+inline void set_height_value(uint8_t *p_data, const bool p_half, const int64_t p_index, const float p_height) {
+	if (p_half) {
+		reinterpret_cast<uint16_t *>(p_data)[p_index] = Math::make_half_float(p_height);
+	} else {
+		reinterpret_cast<float *>(p_data)[p_index] = p_height;
+	}
+}
+
+// Copies p_count heights starting at p_index to r_heights as floats
+inline void get_height_values(const uint8_t *p_data, const bool p_half, const int64_t p_index, float *r_heights, const int p_count) {
+	if (!p_half) {
+		memcpy(r_heights, reinterpret_cast<const float *>(p_data) + p_index, p_count * sizeof(float));
+		return;
+	}
+	const uint16_t *src = reinterpret_cast<const uint16_t *>(p_data) + p_index;
+	for (int i = 0; i < p_count; i++) {
+		r_heights[i] = Math::half_to_float(src[i]);
+	}
+}
+
+// Converts p_count little endian 16-bit values, as stored in r16 files, to heights: value * p_scale + p_offset
+inline void r16_to_heights(const uint8_t *p_src, float *r_heights, const int64_t p_count, const float p_scale, const float p_offset) {
+	for (int64_t i = 0; i < p_count; i++) {
+		uint16_t value = uint16_t(p_src[i * 2]) | uint16_t(p_src[i * 2 + 1]) << 8;
+		r_heights[i] = float(value) * p_scale + p_offset;
+	}
+}
+
 ///////////////////////////
 // Controlmap Handling
 ///////////////////////////